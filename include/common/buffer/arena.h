@@ -0,0 +1,86 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BUF_ARENA_ALIGN 16
+#define BUF_TICK_ARENA_BLOCK_SIZE (256 * 1024)
+
+typedef struct buf_arena_block {
+    struct buf_arena_block* next; // Older block
+    size_t capacity;
+    size_t offset;
+    uint8_t data[];
+} buf_arena_block_t;
+
+/**
+ * @brief Linear allocator, allocations are pointer bumps and are all released together by a reset.
+ */
+typedef struct buf_arena {
+    buf_arena_block_t* head; // Block being allocated from
+    size_t block_size;
+    size_t used; // Bytes handed out since the last reset
+    size_t peak; // Most bytes handed out between two resets
+} buf_arena_t;
+
+/**
+ * @brief Initialize an arena with one block.
+ *
+ * @param arena Pointer to the buf_arena_t to initialize.
+ * @param block_size The size of the first block and the minimum size of blocks added when it runs out.
+ * @return 1 on success, 0 on failure.
+ */
+int buf_arena_init(buf_arena_t* arena, size_t block_size);
+
+/**
+ * @brief Destroy an arena and every allocation made from it.
+ *
+ * @param arena Pointer to the buf_arena_t to destroy.
+ */
+void buf_arena_destroy(buf_arena_t* arena);
+
+/**
+ * @brief Allocate zeroed memory from an arena, adding a block if the current one is full.
+ *
+ * @param arena Pointer to the buf_arena_t.
+ * @param size The number of bytes to allocate.
+ * @return Pointer to the memory, or NULL on failure.
+ */
+void *buf_arena_alloc(buf_arena_t* arena, size_t size);
+
+/**
+ * @brief Release every allocation at once. If the arena overflowed into extra blocks they are
+ * merged into a single block large enough for the peak, so later cycles are one block again.
+ *
+ * @param arena Pointer to the buf_arena_t to reset.
+ */
+void buf_arena_reset(buf_arena_t* arena);
+
+/**
+ * @brief Allocate zeroed memory from the calling thread's tick arena, creating the arena on first use.
+ * The memory stays valid until the same thread calls buf_tick_reset, it must never be freed.
+ *
+ * @param size The number of bytes to allocate.
+ * @return Pointer to the memory, or NULL on failure.
+ */
+void *buf_tick_alloc(size_t size);
+
+/**
+ * @brief Release everything allocated from the calling thread's tick arena, call once the tick's data is sent.
+ */
+void buf_tick_reset(void);
+
+/**
+ * @brief Free the calling thread's tick arena, call before the thread exits.
+ */
+void buf_tick_close(void);
+
+/**
+ * @brief The calling thread's tick arena, for usage reports.
+ *
+ * @return Pointer to the arena, all fields are zero until the thread first allocates from it.
+ */
+const buf_arena_t *buf_tick_arena(void);
+
+#endif /* ARENA_H */
@@ -0,0 +1,64 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdint.h>
+
+#define BUF_POOL_ALIGN 16
+
+/**
+ * @brief Fixed-size object pool, every item is allocated up front and handed out from an intrusive free list.
+ */
+typedef struct buf_pool {
+    void* buffer;
+    void* freeHead; // First free item, each free item stores the next one in its first bytes
+    uint32_t capacity;
+    uint32_t item_size; // Requested size rounded up to BUF_POOL_ALIGN
+    uint32_t count; // Items currently handed out
+    uint32_t peak; // Most items handed out at once
+    uint32_t overflows; // Allocations refused because the pool was empty
+} buf_pool_t;
+
+/**
+ * @brief Initialize an object pool and touch all of its memory so the first allocations do not fault.
+ *
+ * @param pool Pointer to the buf_pool_t to initialize.
+ * @param capacity The number of items in the pool.
+ * @param item_size The size of each item.
+ * @return 1 on success, 0 on failure.
+ */
+int buf_pool_init(buf_pool_t* pool, uint32_t capacity, uint32_t item_size);
+
+/**
+ * @brief Destroy an object pool, items still handed out become invalid.
+ *
+ * @param pool Pointer to the buf_pool_t to destroy.
+ */
+void buf_pool_destroy(buf_pool_t* pool);
+
+/**
+ * @brief Take a zeroed item from the pool.
+ *
+ * @param pool Pointer to the buf_pool_t.
+ * @return Pointer to the item, or NULL if the pool is empty.
+ */
+void *buf_pool_alloc(buf_pool_t* pool);
+
+/**
+ * @brief Return an item to the pool.
+ *
+ * @param pool Pointer to the buf_pool_t.
+ * @param item Pointer to the item to return.
+ * @return 1 on success, 0 if the item does not belong to the pool.
+ */
+int buf_pool_free(buf_pool_t* pool, void* item);
+
+/**
+ * @brief Check if an item was allocated from the pool.
+ *
+ * @param pool Pointer to the buf_pool_t.
+ * @param item Pointer to the item.
+ * @return 1 if the item lies in the pool's memory, 0 otherwise.
+ */
+int buf_pool_owns(const buf_pool_t* pool, const void* item);
+
+#endif /* POOL_H */
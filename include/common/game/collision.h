@@ -7,14 +7,55 @@
 #define COLLISION_SOLID 1
 #define COLLISION_EVENT 2
 
+#define COLLISION_TYPE_BIT(type) (1u << (type))
+
+// Narrows a query, zeroed fields match everything
+typedef struct collision_filter_s {
+    uint32_t layerMask; // Entities on any of these layers
+    uint32_t typeMask; // COLLISION_TYPE_BIT of each entity_type_t to match
+    const entity_t *source; // Never matched
+    uint8_t solidOnly; // Only entities source collides with as solid
+} collision_filter_t;
+
+// Called for each match, return 0 to end the query early
+typedef int (*collision_visit_fn)(entity_t *ent, void *userData);
+
+#define COLLISION_MAX_CIRCLES 32 // Circles per collision_visit_circles call, one bit each in the mask its visitor gets
+
+typedef struct collision_circle_s {
+    GFC_Vector2D center;
+    float radius;
+} collision_circle_t;
+
+// Called once per match with bit i set for each circle i containing the entity, return 0 to end the query early
+typedef int (*collision_visit_circles_fn)(entity_t *ent, uint32_t circleMask, void *userData);
+
+typedef struct collision_hit_s {
+    entity_t *entity;
+    GFC_Vector2D point; // Where the segment enters the entity's bounding box
+    GFC_Vector2I tile; // Tile containing point, tiles themselves are never tested so it need not be blocking
+    float fraction; // Of the way from start to end, 0 if the segment starts inside the box
+} collision_hit_t;
+
 int collision_check(const entity_t *a, const entity_t *b);
 
 int collision_check_world(const world_t *world, const entity_t *ent, GFC_Vector2D newPosition);
 
 int collision_check_world_bounding(const world_t *world, GFC_Rect boundingBox);\
 
-int collision_raycast_world(const world_t *world, const entity_t *ent, GFC_Vector2D start, GFC_Vector2D end, GFC_List *hits);
+// Queries never allocate. Visit functions return the number of matches visited.
+// Segment queries match bounding boxes, circle queries match entity positions.
+// Segment queries only read the chunks and grid cells the segment passes, in the order it reaches them
+
+uint32_t collision_visit_circle(const world_t *world, GFC_Vector2D center, float radius, const collision_filter_t *filter, collision_visit_fn fn, void *userData);
+
+uint32_t collision_visit_segment(const world_t *world, GFC_Vector2D start, GFC_Vector2D end, const collision_filter_t *filter, collision_visit_fn fn, void *userData);
+
+// Visits each entity inside any of up to COLLISION_MAX_CIRCLES circles once, in a single walk over their combined bounds
+uint32_t collision_visit_circles(const world_t *world, const collision_circle_t *circles, uint32_t count, const collision_filter_t *filter, collision_visit_circles_fn fn, void *userData);
 
-GFC_List *collision_get_entities_in_range(const world_t *world, GFC_Vector2D position, float range, uint32_t layerMask);
+// Finds the entity whose bounding box the segment enters first, hit may be NULL. Returns 1 if there is one.
+// Cells are walked in the order the segment reaches them and the walk ends once none can hold a nearer entity
+int collision_raycast(const world_t *world, GFC_Vector2D start, GFC_Vector2D end, const collision_filter_t *filter, collision_hit_t *hit);
 
 #endif /* COLLISION_H */
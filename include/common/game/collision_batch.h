@@ -0,0 +1,68 @@
+#ifndef COLLISION_BATCH_H
+#define COLLISION_BATCH_H
+
+#include <stdint.h>
+
+#include "entity.h"
+
+#define COLLISION_BATCH_SIZE 32 // Entries per batch, one bit each in a kernel's hit mask
+
+#define COLLISION_BATCH_BOUNDS  0x01 // Gather minX, minY, maxX, maxY
+#define COLLISION_BATCH_CENTERS 0x02 // Gather posX, posY
+
+/**
+ * @brief Hot fields of up to COLLISION_BATCH_SIZE entities copied into contiguous arrays, so one query shape can be
+ * tested against several entities per instruction. Lanes past count are padded and never reported as hits.
+ */
+typedef struct collision_batch_s {
+    uint32_t count;
+    uint32_t slots[COLLISION_BATCH_SIZE];
+    uint32_t rows[COLLISION_BATCH_SIZE];
+    float minX[COLLISION_BATCH_SIZE];
+    float minY[COLLISION_BATCH_SIZE];
+    float maxX[COLLISION_BATCH_SIZE];
+    float maxY[COLLISION_BATCH_SIZE];
+    float posX[COLLISION_BATCH_SIZE];
+    float posY[COLLISION_BATCH_SIZE];
+} collision_batch_t;
+
+/**
+ * @brief Fill a batch from the start of a slot array.
+ *
+ * @param batch Pointer to the collision_batch_t to fill.
+ * @param hot The hot arrays of the manager owning the slots.
+ * @param slots Entity slots.
+ * @param count Number of slots available.
+ * @param fields COLLISION_BATCH_BOUNDS and/or COLLISION_BATCH_CENTERS, the fields the kernels will read.
+ * @return The number of slots taken, at most COLLISION_BATCH_SIZE.
+ */
+uint32_t collision_batch_gather(collision_batch_t *batch, const entity_hot_t *hot, const uint32_t *slots, uint32_t count,
+    uint32_t fields);
+
+/**
+ * @brief Test the gathered bounding boxes against a rect, touching edges count as overlapping like gfc_rect_overlap.
+ *
+ * @param batch A batch gathered with COLLISION_BATCH_BOUNDS.
+ * @param minX, minY, maxX, maxY The rect in world space.
+ * @return Bit i is set if entry i overlaps.
+ */
+uint32_t collision_batch_overlap_rect(const collision_batch_t *batch, float minX, float minY, float maxX, float maxY);
+
+/**
+ * @brief Test the gathered positions against a circle, the boundary counts as inside.
+ *
+ * @param batch A batch gathered with COLLISION_BATCH_CENTERS.
+ * @param centerX, centerY The circle's center.
+ * @param radiusSq The circle's radius squared.
+ * @return Bit i is set if entry i is inside.
+ */
+uint32_t collision_batch_inside_circle(const collision_batch_t *batch, float centerX, float centerY, float radiusSq);
+
+/**
+ * @brief Get the instruction set the kernels were compiled for.
+ *
+ * @return "avx", "sse" or "scalar".
+ */
+const char *collision_batch_kernel_name(void);
+
+#endif /* COLLISION_BATCH_H */
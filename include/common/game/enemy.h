@@ -8,11 +8,18 @@
 #include "../render/gf2d_sprite.h"
 
 #define ENEMY_MAX_LEVEL 5
+#define ENEMY_MAX_TARGETS 8
+#define ENEMY_STATE_POOL_SIZE 2048 // Enemy states pre-allocated per match, spawns past this fall back to the heap
 
 #define ENEMY_DIRTY_POSITION 0x0001
 #define ENEMY_DIRTY_HEALTH 0x0002
 #define ENEMY_DIRTY_ATTACK 0x0004
 
+typedef enum enemy_lod_e {
+    ENEMY_LOD_FULL = 0, // Ticks every server tick
+    ENEMY_LOD_REDUCED = 1, // In transit, ticks every ENEMY_LOD_REDUCED_INTERVAL ticks with a larger step
+} enemy_lod_t;
+
 struct def_manager_s;
 struct entity_manager_s;
 
@@ -79,7 +86,8 @@ typedef struct enemy_state_s {
     float attackCooldownTimer;
     float attackTargetTimer;
 
-    GFC_List *targets;
+    entity_handle_t targets[ENEMY_MAX_TARGETS]; // Towers in reach, resolved again before attacking
+    uint8_t numTargets;
     GFC_Vector2I *pathTiles;
     int pathLength;
     int pathIndex;
@@ -89,6 +97,11 @@ typedef struct enemy_state_s {
     uint8_t targetTeamID;
     uint8_t currentTeamID;
     uint32_t dirtyFlags; // Bitfield for tracking what needs to be updated on clients (e.g., position, health, targets)
+
+    uint8_t lodLevel; // Only written outside of the parallel think phase
+    float lodHoldTimer; // Time left before a promoted enemy may drop back to reduced rate
+    float lodElapsed; // Game time accumulated since the enemy last ticked
+    float lodStep; // Step for the current tick, 0 when the tick is skipped
 } enemy_state_t;
 
 typedef struct enemy_def_manager_s enemy_def_manager_t;
@@ -107,6 +120,10 @@ entity_t *enemy_create_by_name(const struct entity_manager_s *entityManager, con
 
 entity_t *enemy_spawn(const struct entity_manager_s *entityManager, const enemy_def_t *def, GFC_Vector2D pos);
 
+// Deferred by towers that see the enemy in range, restores the full tick rate. The payload is an optional float, the
+// time to hold it there
+void enemy_lod_promote(const struct entity_manager_s *entityManager, entity_t *ent, const void *payload);
+
 float enemy_compute_power(const struct enemy_def_manager_s *enemyDefManager, const enemy_def_t *def);
 float enemy_compute_cost(const enemy_def_manager_t *enemyDefManager, const enemy_def_t *def);
 float enemy_compute_weight(const enemy_def_t *def);
@@ -114,10 +131,15 @@ float enemy_compute_weight(const enemy_def_t *def);
 enemy_type_t enemy_type_from_string(const char *str);
 enemy_size_t enemy_size_from_string(const char *str);
 
+void enemy_register_entity_type(void);
+
 void enemy_think(const entity_manager_t *entityManager, entity_t *ent);
 void enemy_update(const entity_manager_t *entityManager, entity_t *ent, float deltaTime);
+void enemy_think_batch(const entity_manager_t *entityManager, entity_t **ents, uint32_t count);
+void enemy_update_batch(const entity_manager_t *entityManager, entity_t **ents, uint32_t count, float deltaTime);
 void enemy_draw(const entity_manager_t *entityManager, entity_t *ent);
 void enemy_destroy(const entity_manager_t *entityManager, entity_t *ent);
+void enemy_despawn_batch(const entity_manager_t *entityManager, entity_t **ents, uint32_t count);
 uint32_t enemy_collides_with(entity_t *ent, entity_t *other);
 
 #endif /* ENEMY_H */
\ No newline at end of file
@@ -1,17 +1,34 @@
 #ifndef ENTITY_H
 #define ENTITY_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "gfc_shape.h"
 #include "gfc_vector.h"
 #include "common/physics.h"
+#include "common/buffer/pool.h"
 
 #define ENTITY_MAX_ID INT64_MAX
+#define ENTITY_ID_AUTO 0 // Passed to entity_new to use the new entity's handle as its network ID
+
+// Handles pack a slot index in the low bits and the slot's generation in the high bits,
+// the generation is bumped whenever the slot is freed so stale handles stop resolving
+#define ENTITY_HANDLE_NULL 0
+#define ENTITY_HANDLE_INDEX_BITS 16
+#define ENTITY_HANDLE_INDEX_MASK ((1u << ENTITY_HANDLE_INDEX_BITS) - 1)
+#define ENTITY_HANDLE_MAX_SLOTS (1u << ENTITY_HANDLE_INDEX_BITS)
+
+// The pool grows one chunk at a time up to its limit, chunks never move so entity pointers stay valid
+#define ENTITY_CHUNK_SIZE 1024
+#define ENTITY_DEFAULT_CAPACITY (ENTITY_CHUNK_SIZE * 5)
+#define ENTITY_DEFAULT_LIMIT ENTITY_HANDLE_MAX_SLOTS
 
 #define ENT_FLAG_ANIMATED    0x0001
-#define ENT_FLAG_COLLIDE_SOLID      0x0002
+#define ENT_FLAG_COLLIDE_SOLID      0x0002 // Blocks enemies, static ones also block the tiles under them, see world_area_blocked
 #define ENT_FLAG_ENEMY     0x0004
+#define ENT_FLAG_PENDING_FREE 0x0008 // Queued for destruction, freed by entity_flush_destroyed
+#define ENT_FLAG_ASLEEP 0x0010 // Left out of think and update passes until woken, see entity_sleep
 
 #define ENT_LAYER_DEFAULT 0x0001
 #define ENT_LAYER_PLAYER  0x0002
@@ -20,10 +37,50 @@
 #define ENT_LAYER_ENEMY   0x0010
 #define ENT_LAYER_RESOURCE 0x0020
 
+#define ENTITY_DEFERRED_PAYLOAD_SIZE 32
+
+struct worker_pool_s;
+
 typedef struct entity_manager_s entity_manager_t;
 
+typedef uint32_t entity_handle_t;
+
+// Archetypes, every entity of a type shares its logic through the type's entity_type_ops_t
+typedef enum entity_type_e {
+    ENTITY_TYPE_STATIC = 0, // Drawn with its sprite, no logic (resources)
+    ENTITY_TYPE_ANIMATED,
+    ENTITY_TYPE_PLAYER,
+    ENTITY_TYPE_TOWER,
+    ENTITY_TYPE_ENEMY,
+    ENTITY_TYPE_PROJECTILE,
+    ENTITY_TYPE_EDITOR_CAMERA,
+    ENTITY_TYPE_COUNT
+} entity_type_t;
+
+// Fields read by spatial queries, stored in contiguous arrays so scans stay in cache.
+// entity_t keeps its own copy for gameplay code, writers publish changes with entity_set_position or entity_sync_hot.
+// Rows are periodically sorted by chunk (see entity_reorder_spatial), look an entity's row up with entity_hot_row.
+// The arrays move when the pool grows, read them through the struct rather than caching them across a spawn
+typedef struct entity_hot_s {
+    uint32_t *rows; // Row of each slot in the arrays below
+    float *posX;
+    float *posY;
+    float *minX; // World space bounding box
+    float *minY;
+    float *maxX;
+    float *maxY;
+    uint16_t *layers; // 0 for free slots
+} entity_hot_t;
+
+#define entity_hot_row(hot, ent) ((hot)->rows[(ent)->_slot])
+
 typedef struct entity_s {
     uint8_t _inUse;
+    uint8_t type; // entity_type_t
+    uint32_t _slot; // Index in the owning manager, fixed for the lifetime of the pool
+    uint32_t _bucketIndex; // Position in its world chunk's or grid cell's layer buckets, see layer_buckets_insert
+    uint32_t _gridCell; // World grid cell plus one, 0 when not in the grid
+    uint32_t _bodyIndex; // Body in the world's physics plus one, 0 when it has none
     int64_t id;
     GFC_Vector2D position;
     GFC_Rect boundingBox;
@@ -34,30 +91,93 @@ typedef struct entity_s {
     void *data;
 
     void *model; // Sprite or AnimatedSprite, depends on animated flag
-    void (*think)(const entity_manager_t *entityManager, struct entity_s *ent);
-    void (*update)(const entity_manager_t *entityManager, struct entity_s *ent, float deltaTime);
-    void (*draw)(const entity_manager_t *entityManager, struct entity_s *ent);
-    void (*destroy)(const entity_manager_t *entityManager, struct entity_s *ent);
-    uint32_t (*collidesWith)(struct entity_s *ent, struct entity_s *other);
-    uint32_t (*onCollide)(struct entity_s *ent, struct entity_s *other, uint32_t type);
 } entity_t;
 
-entity_manager_t *entity_init(uint32_t maxEnts);
+typedef void (*entity_deferred_fn)(const entity_manager_t *entityManager, entity_t *ent, const void *payload);
+
+// Batch passes get every entity of their type, in pass order.
+// Entities freed or marked for freeing earlier in the pass are still listed, skip them with entity_batch_skip
+typedef void (*entity_think_batch_fn)(const entity_manager_t *entityManager, entity_t **ents, uint32_t count);
+typedef void (*entity_update_batch_fn)(const entity_manager_t *entityManager, entity_t **ents, uint32_t count, float deltaTime);
+
+typedef struct entity_type_ops_s {
+    entity_think_batch_fn thinkBatch;
+    entity_update_batch_fn updateBatch;
+    void (*draw)(const entity_manager_t *entityManager, entity_t *ent);
+    void (*destroy)(const entity_manager_t *entityManager, entity_t *ent);
+    uint32_t (*collidesWith)(entity_t *ent, entity_t *other);
+    uint32_t (*onCollide)(entity_t *ent, entity_t *other, uint32_t type);
+    void (*despawnBatch)(const entity_manager_t *entityManager, entity_t **ents, uint32_t count); // Runs once per flush before the entities are freed
+    void (*wake)(const entity_manager_t *entityManager, entity_t *ent, uint32_t sleptTicks); // Catch up on the ticks the entity was left out of
+
+    // Every manager pre-allocates statePoolSize state blocks of stateSize bytes for this type, see entity_new_state
+    uint32_t stateSize;
+    uint32_t statePoolSize;
+} entity_type_ops_t;
+
+typedef struct entity_pool_stats_s {
+    uint32_t numEnts;
+    uint32_t highWater; // Most entities alive at once since the pool was created
+    uint32_t capacity; // Slots allocated so far
+    uint32_t limit; // Hard limit, the pool never grows past this
+    uint32_t numChunks;
+    uint32_t allocFailures; // entity_new calls that failed because the pool was at its limit or out of memory
+    uint32_t numAsleep;
+} entity_pool_stats_t;
+
+// Area impact queued during the think pass, landed later in the tick by projectile_resolve_splashes
+typedef struct entity_splash_s {
+    GFC_Vector2D center;
+    float radius;
+    float damage;
+} entity_splash_t;
+
+#define entity_batch_skip(ent) (!(ent)->_inUse || ((ent)->flags & ENT_FLAG_PENDING_FREE))
+
+entity_manager_t *entity_init(uint32_t initialEnts, uint32_t maxEnts);
 void entity_close(const entity_manager_t* manager);
 
+void entity_register_type(entity_type_t type, const entity_type_ops_t *ops);
+
 entity_t *entity_new(entity_manager_t* manager, int64_t id);
 entity_t *entity_new_animated(const entity_manager_t* manager, int64_t id);
 void entity_free(const entity_manager_t *entityManager, entity_t *ent);
+void entity_queue_destroy(const entity_manager_t *entityManager, entity_t *ent);
+void *entity_new_state(const entity_manager_t *entityManager, entity_t *ent, entity_type_t type);
+const buf_pool_t *entity_get_state_pool(const entity_manager_t *manager, entity_type_t type);
+uint32_t entity_flush_destroyed(const entity_manager_t *entityManager);
+void entity_sleep(const entity_manager_t *entityManager, entity_t *ent, uint32_t ticks);
+void entity_wake(const entity_manager_t *entityManager, entity_t *ent);
+
+uint32_t entity_collides_with(entity_t *ent, entity_t *other);
+uint32_t entity_on_collide(entity_t *ent, entity_t *other, uint32_t type);
 void entity_draw(const entity_manager_t *entityManager, entity_t *ent);
 
 int64_t entity_next_id(entity_manager_t *entityManager);
 void entity_set_id(entity_manager_t *entityManager, entity_t *ent, int64_t id);
 entity_t *entity_get(const entity_manager_t *manager, int64_t id);
 
+entity_handle_t entity_get_handle(const entity_manager_t *manager, const entity_t *ent);
+entity_t *entity_resolve(const entity_manager_t *manager, entity_handle_t handle);
+entity_t *entity_from_slot(const entity_manager_t *manager, uint32_t slot);
+int entity_handle_valid(const entity_manager_t *manager, entity_handle_t handle);
+
+const entity_hot_t *entity_get_hot(const entity_manager_t *manager);
+void entity_sync_hot(const entity_manager_t *manager, const entity_t *ent);
+void entity_set_position(const entity_manager_t *manager, entity_t *ent, GFC_Vector2D position);
+void entity_get_pool_stats(const entity_manager_t *manager, entity_pool_stats_t *stats);
+uint32_t entity_reorder_spatial(entity_manager_t *manager);
+
+int entity_queue_splash(const entity_manager_t *manager, const entity_splash_t *splash);
+entity_splash_t *entity_get_splashes(const entity_manager_t *manager, uint32_t *count);
+void entity_clear_splashes(const entity_manager_t *manager);
+
 void entity_draw_animated(const entity_manager_t *entityManager, entity_t *ent);
-void entity_update_animated(const entity_manager_t *entityManager, entity_t *ent, float deltaTime);
+void entity_update_animated_batch(const entity_manager_t *entityManager, entity_t **ents, uint32_t count, float deltaTime);
 
 void entity_think_all(const entity_manager_t *manager);
+void entity_think_all_parallel(entity_manager_t *manager, struct worker_pool_s *pool);
+void entity_defer(const entity_manager_t *entityManager, entity_t *ent, entity_deferred_fn fn, const void *payload, size_t size);
 void entity_update_all(const entity_manager_t *manager, float deltaTime);
 void entity_draw_all(const entity_manager_t *manager);
 
@@ -66,4 +66,9 @@ typedef struct game_s {
 
 extern __thread game_t g_game;
 
+/**
+ * @brief Register the logic of every gameplay entity type, call once at startup before spawning entities.
+ */
+void game_register_entity_types(void);
+
 #endif /* COMMON_GAME_H */
\ No newline at end of file
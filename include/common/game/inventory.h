@@ -21,6 +21,8 @@ typedef struct inventory_transaction_s {
     uint32_t capacity;
     /* whether this transaction is an addition (1) or removal (0) */
     uint8_t isAddition;
+    /* allocated from the tick arena, released by the arena reset rather than inventory_transaction_destroy */
+    uint8_t transient;
 } inventory_transaction_t;
 
 void inventory_init(inventory_t *inventory, uint32_t capacity);
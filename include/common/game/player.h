@@ -51,6 +51,8 @@ player_t *player_create(uint32_t id, const char *name);
 
 void player_destroy(player_t *player);
 
+void player_register_entity_type(void);
+
 entity_t *player_entity_spawn(const struct entity_manager_s *entityManager, player_t *player, GFC_Vector2D pos, const char * sprite);
 
 /**
@@ -2,6 +2,9 @@
 #define PROJECTILE_H
 
 #include "gfc_vector.h"
+#include "common/game/entity.h"
+
+#define PROJECTILE_STATE_POOL_SIZE 1024 // Projectile states pre-allocated per match, spawns past this fall back to the heap
 
 struct tower_state_s;
 struct entity_s;
@@ -13,10 +16,19 @@ typedef struct projectile_state_s {
     uint8_t areaDamage;
     GFC_Vector2D direction;
     GFC_Vector2D distanceTraveled;
-    struct tower_state_s *sourceTower;
+    entity_handle_t sourceTower; // Tower entity that fired, may be gone by the time the projectile lands
     struct entity_s *entity;
 } projectile_state_t;
 
+void projectile_register_entity_type(void);
+
+void projectile_think_batch(const entity_manager_t *entityManager, entity_t **ents, uint32_t count);
+void projectile_update_batch(const entity_manager_t *entityManager, entity_t **ents, uint32_t count, float deltaTime);
+
+// Lands the tick's queued area impacts in one pass and broadcasts the enemies' new health in batches,
+// call on the server once the think pass's deferred work is committed
+void projectile_resolve_splashes(const entity_manager_t *entityManager);
+
 int projectile_spawn(const entity_manager_t *entityManager, float speed, float damage, float range, uint8_t areaDamage, GFC_Vector2D direction, const char *spriteModel, struct tower_state_s *sourceTower);
 
 #endif /* PROJECTILE_H */
\ No newline at end of file
@@ -54,6 +54,7 @@ typedef struct tower_def_s {
     char description[256];
     tower_type_t type;
     float size;
+    uint8_t solid; // Blocks enemies and their paths, "solid" in the def file, defaults to true
     float maxHealth[TOWER_MAX_LEVEL];
     int numWeapons;
     const tower_weapon_def_t *weaponDefs;
@@ -238,6 +239,14 @@ inventory_transaction_t *tower_get_cost_transaction(const tower_def_t *def, int
 
 uint32_t tower_collides_with(entity_t *ent, entity_t *other);
 
+/**
+ * @brief Registers the tower entity type, its batch think/update passes and callbacks.
+ */
+void tower_register_entity_type(void);
+
+void tower_think_batch(const entity_manager_t *entityManager, entity_t **ents, uint32_t count);
+void tower_update_batch(const entity_manager_t *entityManager, entity_t **ents, uint32_t count, float deltaTime);
+
 GFC_Vector2D tower_snap_to_grid(const tower_def_t *towerDef, GFC_Vector2D position);
 
 #endif /* TOWER_H */
\ No newline at end of file
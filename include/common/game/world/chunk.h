@@ -3,15 +3,21 @@
 
 #include "gfc_list.h"
 
+#include "common/game/world/layer_buckets.h"
+#include "common/game/world/tile.h"
+
 #define CHUNK_TILE_SIZE 16
 
 struct world_s;
+struct entity_s;
 
 typedef struct chunk_s {
     int x;
     int y;
     uint32_t tiles[CHUNK_TILE_SIZE][CHUNK_TILE_SIZE];
-    GFC_List *entities;
+    // One bit plane per TILE_FLAG, bit x of row y is set if tile (x, y) has the flag. Rebuilt by chunk_refresh_tile
+    uint16_t tileFlags[TILE_FLAG_COUNT][CHUNK_TILE_SIZE];
+    layer_buckets_t entities; // Slots of the entities in this chunk, resolve them with entity_from_slot
     SDL_Texture *texture;
 } chunk_t;
 
@@ -25,11 +31,39 @@ void chunk_serialize(const chunk_t *chunk, uint32_t *data);
 
 chunk_t *chunk_get(struct world_s *world, int x, int y);
 
-int chunk_has_entity(const chunk_t *chunk, const void *entity);
+int chunk_has_entity(const chunk_t *chunk, const struct entity_s *entity);
+
+void chunk_add_entity(chunk_t *chunk, struct entity_s *entity);
+
+void chunk_remove_entity(chunk_t *chunk, const struct entity_s *entity);
+
+/**
+ * @brief Rebuild a tile's bits in the tile flag planes from its tile definition.
+ *
+ * @param chunk The chunk.
+ * @param x, y The tile in chunk coordinates.
+ */
+void chunk_refresh_tile(chunk_t *chunk, int x, int y);
 
-void chunk_add_entity(chunk_t *chunk, void *entity);
+/**
+ * @brief Check a tile's flag.
+ *
+ * @param chunk The chunk.
+ * @param x, y The tile in chunk coordinates.
+ * @param flag A single TILE_FLAG.
+ * @return 1 if the tile has the flag, 0 otherwise or if the tile is outside the chunk.
+ */
+int chunk_test_tile_flag(const chunk_t *chunk, int x, int y, uint32_t flag);
 
-void chunk_remove_entity(chunk_t *chunk, const void *entity);
+/**
+ * @brief Get the bits of a tile flag plane for a row of tiles.
+ *
+ * @param chunk The chunk.
+ * @param y The row in chunk coordinates.
+ * @param flag A single TILE_FLAG.
+ * @return Bit x is set if tile (x, y) has the flag, 0 if the row is outside the chunk.
+ */
+uint16_t chunk_tile_flag_row(const chunk_t *chunk, int y, uint32_t flag);
 
 SDL_Texture *chunk_create_texture(const chunk_t *chunk, SDL_Renderer *renderer);
 
@@ -0,0 +1,98 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include <stdint.h>
+
+#include "gfc_vector.h"
+
+#include "common/game/world/layer_buckets.h"
+
+struct entity_s;
+
+typedef layer_buckets_t grid_cell_t; // Slots of the entities in a cell, resolve them with entity_from_slot
+
+/**
+ * @brief Uniform grid over the world for the broad phase of moving entities. Entities are bucketed by position,
+ * queries grow their bounds by the margin so boxes reaching into neighbouring cells are still found.
+ */
+typedef struct grid_s {
+    int width; // Cells
+    int height;
+    float cellSize;
+    float invCellSize;
+    float margin; // Furthest any inserted entity's bounding box reaches from its position
+    grid_cell_t *cells; // Row major, width cells per row
+} grid_t;
+
+/**
+ * @brief Initialize a grid covering a world area.
+ *
+ * @param grid Pointer to the grid_t to initialize.
+ * @param worldWidth The width of the world in pixels.
+ * @param worldHeight The height of the world in pixels.
+ * @param cellSize The edge length of a cell in pixels.
+ * @return 1 on success, 0 on failure.
+ */
+int grid_init(grid_t *grid, float worldWidth, float worldHeight, float cellSize);
+
+/**
+ * @brief Destroy a grid, the entities in it are not touched.
+ *
+ * @param grid Pointer to the grid_t to destroy.
+ */
+void grid_destroy(grid_t *grid);
+
+/**
+ * @brief Add an entity at its current position.
+ *
+ * @param grid Pointer to the grid_t.
+ * @param ent The entity to add.
+ * @return 1 on success, 0 on failure.
+ */
+int grid_insert(grid_t *grid, struct entity_s *ent);
+
+/**
+ * @brief Move an entity to the cell of a new position, does nothing if the cell does not change.
+ *
+ * @param grid Pointer to the grid_t.
+ * @param ent The entity to move, must be in the grid.
+ * @param newPos The entity's new position.
+ */
+void grid_move(grid_t *grid, struct entity_s *ent, GFC_Vector2D newPos);
+
+/**
+ * @brief Remove an entity from the grid, does nothing if it is not in it.
+ *
+ * @param grid Pointer to the grid_t.
+ * @param ent The entity to remove.
+ */
+void grid_remove(grid_t *grid, struct entity_s *ent);
+
+/**
+ * @brief Check if an entity is in a grid.
+ *
+ * @param ent The entity.
+ * @return 1 if the entity was inserted and not removed since, 0 otherwise.
+ */
+int grid_contains(const struct entity_s *ent);
+
+/**
+ * @brief Get the cells that may hold entities whose bounding boxes overlap an area, margin included.
+ *
+ * @param grid Pointer to the grid_t.
+ * @param minX, minY, maxX, maxY The area in world space.
+ * @param x0, y0, x1, y1 Receive the inclusive cell range, clamped to the grid.
+ * @return 1 if the range holds at least one cell, 0 otherwise.
+ */
+int grid_cell_range(const grid_t *grid, float minX, float minY, float maxX, float maxY, int *x0, int *y0, int *x1, int *y1);
+
+/**
+ * @brief Get a cell by its coordinates.
+ *
+ * @param grid Pointer to the grid_t.
+ * @param x, y The cell coordinates.
+ * @return Pointer to the cell, or NULL if the coordinates are outside the grid.
+ */
+const grid_cell_t *grid_get_cell(const grid_t *grid, int x, int y);
+
+#endif /* GRID_H */
@@ -0,0 +1,79 @@
+#ifndef LAYER_BUCKETS_H
+#define LAYER_BUCKETS_H
+
+#include <stdint.h>
+
+#define LAYER_BUCKET_COUNT 7 // One per ENT_LAYER bit, then one for entities on several layers or none
+#define LAYER_BUCKET_MIXED (LAYER_BUCKET_COUNT - 1)
+#define LAYER_BUCKET_ALL ((1u << LAYER_BUCKET_COUNT) - 1)
+#define LAYER_BUCKETS_INITIAL_CAPACITY 8
+
+struct entity_s;
+
+/**
+ * @brief Entity slots of one spatial container grouped by collision layer. Each bucket is a contiguous run of the
+ * slot array, so a query for one layer reads only that run and a full scan still reads slots[0..count). Entities
+ * keep their position in _bucketIndex, insertion and removal move at most one entry per bucket.
+ */
+typedef struct layer_buckets_s {
+    uint32_t *slots;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t ends[LAYER_BUCKET_COUNT]; // Bucket b spans [ends[b - 1], ends[b]), bucket 0 starts at 0
+} layer_buckets_t;
+
+/**
+ * @brief Get the buckets a layer mask query has to read.
+ *
+ * @param layerMask Mask of ENT_LAYER flags, 0 for every layer.
+ * @return Bit mask of bucket indices, the mixed bucket is always included.
+ */
+uint32_t layer_buckets_mask(uint32_t layerMask);
+
+/**
+ * @brief Free the slot array, the entities are not touched.
+ *
+ * @param buckets Pointer to the layer_buckets_t.
+ */
+void layer_buckets_free(layer_buckets_t *buckets);
+
+/**
+ * @brief Check if an entity is listed.
+ *
+ * @param buckets Pointer to the layer_buckets_t.
+ * @param ent The entity.
+ * @return 1 if the entity is listed, 0 otherwise.
+ */
+int layer_buckets_contains(const layer_buckets_t *buckets, const struct entity_s *ent);
+
+/**
+ * @brief Add an entity to the bucket of its layers, which must not change while it is listed.
+ *
+ * @param buckets Pointer to the layer_buckets_t.
+ * @param ent The entity to add, must not be listed in any layer_buckets_t.
+ * @return 1 on success, 0 on failure.
+ */
+int layer_buckets_insert(layer_buckets_t *buckets, struct entity_s *ent);
+
+/**
+ * @brief Remove an entity, does nothing if it is not listed.
+ *
+ * @param buckets Pointer to the layer_buckets_t.
+ * @param ent The entity to remove.
+ */
+void layer_buckets_remove(layer_buckets_t *buckets, const struct entity_s *ent);
+
+/**
+ * @brief Get the next run of slots in the selected buckets. Neighbouring selected buckets come back as one run.
+ *
+ * @param buckets Pointer to the layer_buckets_t.
+ * @param bucketMask Buckets to read, see layer_buckets_mask.
+ * @param bucket Bucket to continue from, start at 0. Advanced past the returned run.
+ * @param slots Receives the first slot of the run.
+ * @param count Receives the length of the run.
+ * @return 1 if a non-empty run was found, 0 once the selected buckets are exhausted.
+ */
+int layer_buckets_next_span(const layer_buckets_t *buckets, uint32_t bucketMask, uint32_t *bucket,
+    const uint32_t **slots, uint32_t *count);
+
+#endif /* LAYER_BUCKETS_H */
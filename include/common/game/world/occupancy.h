@@ -0,0 +1,77 @@
+#ifndef OCCUPANCY_H
+#define OCCUPANCY_H
+
+#include <stdint.h>
+
+#define OCCUPANCY_SOLID   0x01 // Tiles under static entities that block movement
+#define OCCUPANCY_NO_WALK 0x02 // Tiles ground units cannot walk on
+#define OCCUPANCY_NO_FLY  0x04 // Tiles air units cannot fly over
+#define OCCUPANCY_PLANE_COUNT 3
+
+/**
+ * @brief Per tile bitmaps of what blocks movement, one bit per tile and one bitmap per OCCUPANCY flag. Rows are
+ * padded to whole words so an area test reads a handful of words per row. Solid tiles are reference counted, so
+ * overlapping blockers can be added and removed in any order.
+ */
+typedef struct occupancy_s {
+    int width; // Tiles
+    int height;
+    uint32_t wordsPerRow;
+    uint64_t *planes[OCCUPANCY_PLANE_COUNT];
+    uint8_t *solidCounts; // Blockers over each tile
+} occupancy_t;
+
+/**
+ * @brief Initialize an occupancy map with every tile clear.
+ *
+ * @param occupancy Pointer to the occupancy_t to initialize.
+ * @param width The width in tiles.
+ * @param height The height in tiles.
+ * @return 1 on success, 0 on failure.
+ */
+int occupancy_init(occupancy_t *occupancy, int width, int height);
+
+/**
+ * @brief Destroy an occupancy map.
+ *
+ * @param occupancy Pointer to the occupancy_t to destroy.
+ */
+void occupancy_destroy(occupancy_t *occupancy);
+
+/**
+ * @brief Set or clear a tile in one of the tile planes, does nothing outside the map.
+ *
+ * @param occupancy Pointer to the occupancy_t.
+ * @param plane OCCUPANCY_NO_WALK or OCCUPANCY_NO_FLY.
+ * @param x, y The tile.
+ * @param blocked 1 to set the tile, 0 to clear it.
+ */
+void occupancy_set_tile(occupancy_t *occupancy, uint32_t plane, int x, int y, int blocked);
+
+/**
+ * @brief Add a blocker over an area, clamped to the map.
+ *
+ * @param occupancy Pointer to the occupancy_t.
+ * @param x0, y0, x1, y1 The inclusive tile range.
+ */
+void occupancy_add_solid(occupancy_t *occupancy, int x0, int y0, int x1, int y1);
+
+/**
+ * @brief Remove a blocker added with occupancy_add_solid over the same area.
+ *
+ * @param occupancy Pointer to the occupancy_t.
+ * @param x0, y0, x1, y1 The inclusive tile range.
+ */
+void occupancy_remove_solid(occupancy_t *occupancy, int x0, int y0, int x1, int y1);
+
+/**
+ * @brief Check if any tile of an area is set in any of the given planes. Tiles outside the map count as set.
+ *
+ * @param occupancy Pointer to the occupancy_t.
+ * @param planes Mask of OCCUPANCY flags.
+ * @param x0, y0, x1, y1 The inclusive tile range.
+ * @return 1 if the area is blocked, 0 if it is clear.
+ */
+int occupancy_test_area(const occupancy_t *occupancy, uint32_t planes, int x0, int y0, int x1, int y1);
+
+#endif /* OCCUPANCY_H */
@@ -5,6 +5,14 @@
 
 #include "../../render/gf2d_sprite.h"
 
+// Tile properties as bits, bit n of TILE_FLAG_COUNT is plane n of a chunk's tileFlags
+#define TILE_FLAG_WALKABLE     0x01
+#define TILE_FLAG_FLYABLE      0x02
+#define TILE_FLAG_BUILDABLE    0x04
+#define TILE_FLAG_HARMFUL      0x08
+#define TILE_FLAG_MODIFY_SPEED 0x10
+#define TILE_FLAG_COUNT 5
+
 typedef struct tile_properties_s {
     short walkable;
     short flyable;
@@ -19,6 +27,7 @@ typedef struct tile_properties_s {
 typedef struct tile_s {
     uint32_t id;
     tile_properties_t properties;
+    uint32_t flags; // TILE_FLAG bits of the properties
     Sprite *sprite;
     uint32_t spriteFrame;
 } tile_t;
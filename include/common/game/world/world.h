@@ -2,11 +2,19 @@
 #define WORLD_H
 
 #include "chunk.h"
+#include "grid.h"
+#include "occupancy.h"
 #include "gfc_vector.h"
+#include "common/game/entity.h"
 #include "common/game/item.h"
+#include "common/physics.h"
 #include "common/game/world/tile.h"
 
 #define TILE_SIZE 48
+#define WORLD_GRID_CELL_TILES 2 // Broad phase cell edge, a chunk is CHUNK_TILE_SIZE / WORLD_GRID_CELL_TILES cells across
+
+// Entities on these layers move and are tracked by the world grid, the rest stay in their chunk's array
+#define WORLD_DYNAMIC_LAYERS (ENT_LAYER_PLAYER | ENT_LAYER_PROJECTILE | ENT_LAYER_ENEMY)
 
 struct def_manager_s;
 struct entity_s;
@@ -20,7 +28,7 @@ typedef enum world_object_type_e {
 } world_object_type_t;
 
 typedef struct selected_tower_s {
-    struct entity_s *tower;
+    entity_handle_t tower;
     int upgradeLevel;
     struct overlay_element_s *element;
 } selected_tower_t;
@@ -30,6 +38,10 @@ typedef struct world_s {
     uint8_t local;
 
     struct chunk_s *chunks;
+    float chunkMargin; // Furthest any chunk entity's bounding box reaches from its position
+    grid_t grid;
+    occupancy_t occupancy; // Static blockers and terrain per tile, kept current by entity add/remove and world_refresh_tile
+    phys_body_manager_t bodies; // Movers resolved together each tick, see phys_step
 
     selected_tower_t *selected_tower;
 } world_t;
@@ -52,6 +64,44 @@ int world_on_click(world_t *world, uint32_t mouseButton, int x, int y);
 
 void world_clear(world_t *world);
 
+/**
+ * @brief Re-read a tile's properties into its chunk's tile flags and the occupancy map, call after changing a chunk's tiles.
+ *
+ * @param world The world.
+ * @param tileX, tileY The tile in world tile coordinates.
+ */
+void world_refresh_tile(world_t *world, int tileX, int tileY);
+
+/**
+ * @brief Check if anything in the given occupancy planes covers an area, without looking at entities.
+ *
+ * @param world The world.
+ * @param area The area in world space, edges that only touch a tile do not cover it.
+ * @param planes Mask of OCCUPANCY flags.
+ * @return 1 if the area is blocked or leaves the world, 0 otherwise.
+ */
+int world_area_blocked(const world_t *world, GFC_Rect area, uint32_t planes);
+
+/**
+ * @brief Check a flag of the tile under a position.
+ *
+ * @param world The world.
+ * @param worldPos The position in world space.
+ * @param flag A single TILE_FLAG.
+ * @return 1 if the tile has the flag, 0 otherwise or if the position is outside the world.
+ */
+int world_test_tile_flag(const world_t *world, GFC_Vector2D worldPos, uint32_t flag);
+
+/**
+ * @brief Check if every tile of an area has a flag.
+ *
+ * @param world The world.
+ * @param x0, y0, x1, y1 The inclusive range in world tile coordinates.
+ * @param flag A single TILE_FLAG.
+ * @return 1 if all tiles have the flag, 0 otherwise or if the range leaves the world.
+ */
+int world_tiles_have_flag(const world_t *world, int x0, int y0, int x1, int y1, uint32_t flag);
+
 void world_draw(const world_t *world);
 
 int world_add_entity(world_t *world, struct entity_s *ent);
@@ -18,6 +18,7 @@ typedef struct network_settings_s {
 
     network_event_callback_t onConnect;
     network_event_callback_t onDisconnect;
+    network_event_callback_t onReceive; // Dispatched inline through network_handle_receive when NULL
 } network_settings_t;
 
 typedef struct network_s {
@@ -31,6 +32,9 @@ int network_init(network_t *network, const network_settings_t *settings, void *n
 void network_deinit(network_t *network);
 
 void network_tick(network_t *network);
+int network_wait(network_t *network, uint32_t timeoutMs);
+void network_handle_receive(network_t *network, const net_udp_event_t *context);
+void network_dispatch_packet(network_t *network, net_udp_packet_t *rawPacket, void *handlerContext); // Handlers get handlerContext, destroys the packet
 int network_send(net_udp_peer_t *peer, void *pkt, uint32_t flags);
 int network_send_batch(net_udp_peer_t *peer, void **pkts, uint32_t count);
 
@@ -27,6 +27,8 @@ typedef enum {
     PACKET_S2C_INVENTORY_UPDATE,
     PACKET_S2C_GAME_STATE_SNAPSHOT,
     PACKET_S2C_ENEMY_SNAPSHOT,
+    PACKET_S2C_ENEMY_DESPAWN_BATCH,
+    PACKET_S2C_ENEMY_DAMAGE_BATCH,
     PACKET_COUNT
 } packet_id_t;
 
@@ -217,4 +219,25 @@ typedef struct s2c_enemy_snapshot_packet_s {
     enemy_snapshot_data_t eventData;
 } s2c_enemy_snapshot_packet_t;
 
+#define ENEMY_DESPAWN_BATCH_MAX 64
+
+typedef struct s2c_enemy_despawn_batch_packet_s {
+    PACKET_HEADER
+    uint16_t count;
+    int64_t enemyIDs[ENEMY_DESPAWN_BATCH_MAX];
+} s2c_enemy_despawn_batch_packet_t;
+
+#define ENEMY_DAMAGE_BATCH_MAX 64
+
+typedef struct enemy_damage_entry_s {
+    int64_t enemyID;
+    float health; // After the damage
+} enemy_damage_entry_t;
+
+typedef struct s2c_enemy_damage_batch_packet_s {
+    PACKET_HEADER
+    uint16_t count;
+    enemy_damage_entry_t entries[ENEMY_DAMAGE_BATCH_MAX];
+} s2c_enemy_damage_batch_packet_t;
+
 #endif /* NETWORK_PACKET_DEFINITIONS_H */
\ No newline at end of file
@@ -25,6 +25,10 @@ void handle_s2c_game_state_snapshot(const s2c_game_state_snapshot_packet_t *, vo
 
 void handle_s2c_enemy_snapshot(const s2c_enemy_snapshot_packet_t *, void *);
 
+void handle_s2c_enemy_despawn_batch(const s2c_enemy_despawn_batch_packet_t *, void *);
+
+void handle_s2c_enemy_damage_batch(const s2c_enemy_damage_batch_packet_t *, void *);
+
 void receive_c2s_player_join_request(buffer_t buf, buffer_offset_t *off, void *c);
 
 void receive_s2c_player_join_response(buffer_t buf, buffer_offset_t *off, void *c);
@@ -47,6 +51,10 @@ void receive_s2c_game_state_snapshot(buffer_t buf, buffer_offset_t *off, void *c
 
 void receive_s2c_enemy_snapshot(buffer_t buf, buffer_offset_t *off, void *c);
 
+void receive_s2c_enemy_despawn_batch(buffer_t buf, buffer_offset_t *off, void *c);
+
+void receive_s2c_enemy_damage_batch(buffer_t buf, buffer_offset_t *off, void *c);
+
 void prepare_send_c2s_player_join_request(buffer_t buf, buffer_offset_t *off, void *c);
 
 void prepare_send_s2c_player_join_response(buffer_t buf, buffer_offset_t *off, void *c);
@@ -69,6 +77,10 @@ void prepare_send_s2c_game_state_snapshot(buffer_t buf, buffer_offset_t *off, vo
 
 void prepare_send_s2c_enemy_snapshot(buffer_t buf, buffer_offset_t *off, void *c);
 
+void prepare_send_s2c_enemy_despawn_batch(buffer_t buf, buffer_offset_t *off, void *c);
+
+void prepare_send_s2c_enemy_damage_batch(buffer_t buf, buffer_offset_t *off, void *c);
+
 typedef void (*packet_receive_fn)(
     buffer_t buffer,
     buffer_offset_t *offset,
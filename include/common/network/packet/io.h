@@ -120,4 +120,16 @@ void read_s2c_enemy_snapshot(buffer_t, buffer_offset_t *, s2c_enemy_snapshot_pac
 
 void create_s2c_enemy_snapshot(s2c_enemy_snapshot_packet_t *pkt, int64_t enemyID, uint32_t eventID, enemy_snapshot_data_t *eventData);
 
+void write_s2c_enemy_despawn_batch(buffer_t, buffer_offset_t *, const s2c_enemy_despawn_batch_packet_t *);
+
+void read_s2c_enemy_despawn_batch(buffer_t, buffer_offset_t *, s2c_enemy_despawn_batch_packet_t *);
+
+void create_s2c_enemy_despawn_batch(s2c_enemy_despawn_batch_packet_t *pkt, const int64_t *enemyIDs, uint16_t count);
+
+void write_s2c_enemy_damage_batch(buffer_t, buffer_offset_t *, const s2c_enemy_damage_batch_packet_t *);
+
+void read_s2c_enemy_damage_batch(buffer_t, buffer_offset_t *, s2c_enemy_damage_batch_packet_t *);
+
+void create_s2c_enemy_damage_batch(s2c_enemy_damage_batch_packet_t *pkt, const enemy_damage_entry_t *entries, uint16_t count);
+
 #endif /* NETWORK_PACKET_IO_H */
\ No newline at end of file
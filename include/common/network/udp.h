@@ -6,6 +6,7 @@
 #include <enet/enet.h>
 
 #include "common/buffer/ring.h"
+#include "common/thread/condvar.h"
 #include "common/thread/mutex.h"
 #include "common/thread/thread.h"
 
@@ -380,6 +381,8 @@ typedef struct net_udp_host_s {
     thread_t hostThread;
     /** Mutex for synchronizing access to the host state. */
     mutex_t hostLock;
+    /** @internal Signaled with hostLock held whenever the host thread queues events. */
+    cond_t eventCond;
     /** Current state of the host. */
     net_host_state_t state;
     /** @internal Timestamp marking the start of shutdown. */
@@ -515,6 +518,16 @@ static inline net_udp_peer_t *net_udp_host_connect(const net_udp_host_t *host, c
  */
 int net_udp_host_check_events(net_udp_host_t *host, net_udp_event_t *event);
 
+/**
+ * @brief Block until the host thread queues an event or the timeout expires.
+ * @note Only server hosts run a host thread, client hosts return immediately.
+ *
+ * @param host Pointer to the net_udp_host_t.
+ * @param timeoutMs Maximum time to wait in milliseconds.
+ * @return 1 if events are queued, 0 if the wait timed out.
+ */
+int net_udp_host_wait_events(net_udp_host_t *host, uint32_t timeoutMs);
+
 /**
  * @brief Flush any queued outgoing packets for the UDP host.
  *
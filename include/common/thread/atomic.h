@@ -49,4 +49,15 @@ static inline void atomic_u32_store_release(atomic_u32_t *a, uint32_t v) {
     atomic_store_explicit(a, v, memory_order_release);
 }
 
+/**
+ * @brief Atomically add to an unsigned 32-bit integer with relaxed memory order.
+ *
+ * @param a Pointer to the atomic_u32_t to add to.
+ * @param v The value to add.
+ * @return The value held before the addition.
+ */
+static inline uint32_t atomic_u32_fetch_add_relaxed(atomic_u32_t *a, uint32_t v) {
+    return atomic_fetch_add_explicit(a, v, memory_order_relaxed);
+}
+
 #endif /* ATOMIC_H */
\ No newline at end of file
@@ -25,7 +25,7 @@ static inline void mutex_init(mutex_t *mutex) {
  * @param mutex Pointer to the mutex_t to lock.
  */
 static inline void mutex_lock(mutex_t *mutex) {
-    pthread_mutex_init(mutex, NULL);
+    pthread_mutex_lock(mutex);
 }
 
 /**
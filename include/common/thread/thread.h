@@ -66,4 +66,13 @@ static inline void thread_sleepMs(unsigned ms) {
     nanosleep(&ts, NULL);
 }
 
+/**
+ * @brief Get the number of processors currently online.
+ * @return The number of online processors, at least 1.
+ */
+static inline unsigned thread_hardware_concurrency(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (unsigned) count : 1;
+}
+
 #endif /* THREAD_H */
\ No newline at end of file
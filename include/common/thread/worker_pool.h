@@ -0,0 +1,50 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <stdint.h>
+
+/**
+ * @brief Job function run by every participant of a worker pool dispatch.
+ *
+ * @param userData Pointer to the user data passed to worker_pool_run.
+ * @param workerIndex Index of the participant, 0 is always the calling thread.
+ * @param numWorkers Total number of participants, including the calling thread.
+ */
+typedef void (*worker_job_t)(void *userData, uint32_t workerIndex, uint32_t numWorkers);
+
+typedef struct worker_pool_s worker_pool_t;
+
+/**
+ * @brief Create a pool of persistent worker threads.
+ * @note The calling thread always takes part in a dispatch, so a pool with zero threads runs jobs inline.
+ *
+ * @param numThreads Number of background threads to spawn.
+ * @return Pointer to the created pool, or NULL on failure.
+ */
+worker_pool_t *worker_pool_create(uint32_t numThreads);
+
+/**
+ * @brief Stop and join all worker threads, then free the pool.
+ *
+ * @param pool Pointer to the worker_pool_t to destroy.
+ */
+void worker_pool_destroy(worker_pool_t *pool);
+
+/**
+ * @brief Get the number of participants in a dispatch, including the calling thread.
+ *
+ * @param pool Pointer to the worker_pool_t.
+ * @return The number of participants, 1 if the pool is NULL.
+ */
+uint32_t worker_pool_get_size(const worker_pool_t *pool);
+
+/**
+ * @brief Run a job on every worker and the calling thread, blocking until all of them return.
+ *
+ * @param pool Pointer to the worker_pool_t, may be NULL to run the job inline.
+ * @param job The job function to run.
+ * @param userData Pointer to user data passed to the job.
+ */
+void worker_pool_run(worker_pool_t *pool, worker_job_t job, void *userData);
+
+#endif /* WORKER_POOL_H */
@@ -0,0 +1,91 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+
+#define TIMER_WHEEL_BITS 8
+#define TIMER_WHEEL_SLOTS (1u << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 3 // Deadlines up to 2^24 ticks away are placed directly, later ones wait in the top level
+#define TIMER_WHEEL_NONE UINT32_MAX
+
+typedef void (*timer_wheel_fire_fn)(void *userData, uint32_t timer);
+
+/**
+ * @brief Hierarchical timer wheel counting in ticks. Timers are identified by a caller chosen index below the
+ * wheel's capacity, each index holds at most one pending deadline. Scheduling and cancelling are O(1) and
+ * advancing only touches the timers that are due, plus one bucket cascade every TIMER_WHEEL_SLOTS ticks.
+ */
+typedef struct timer_wheel_s {
+    uint64_t now; // Last tick advanced to
+    uint32_t capacity;
+    uint32_t count; // Pending timers
+    uint64_t *deadlines;
+    uint32_t *next; // Bucket lists, TIMER_WHEEL_NONE terminated
+    uint32_t *prev;
+    uint32_t *buckets; // Bucket each timer is linked into, TIMER_WHEEL_NONE if it is not pending
+    uint32_t heads[TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS];
+} timer_wheel_t;
+
+/**
+ * @brief Initialize a timer wheel.
+ *
+ * @param wheel Pointer to the timer_wheel_t to initialize.
+ * @param capacity The number of timer indices.
+ * @return 1 on success, 0 on failure.
+ */
+int timer_wheel_init(timer_wheel_t* wheel, uint32_t capacity);
+
+/**
+ * @brief Destroy a timer wheel, pending timers are dropped without firing.
+ *
+ * @param wheel Pointer to the timer_wheel_t to destroy.
+ */
+void timer_wheel_destroy(timer_wheel_t* wheel);
+
+/**
+ * @brief Grow the wheel to hold more timer indices, pending timers are kept.
+ *
+ * @param wheel Pointer to the timer_wheel_t.
+ * @param capacity The new number of timer indices, ignored if not larger than the current one.
+ * @return 1 on success, 0 on failure.
+ */
+int timer_wheel_reserve(timer_wheel_t* wheel, uint32_t capacity);
+
+/**
+ * @brief Schedule a timer to fire a number of ticks from now, replacing its pending deadline if it has one.
+ *
+ * @param wheel Pointer to the timer_wheel_t.
+ * @param timer The timer index.
+ * @param delay Ticks until the timer fires, 0 is treated as 1.
+ */
+void timer_wheel_schedule(timer_wheel_t* wheel, uint32_t timer, uint32_t delay);
+
+/**
+ * @brief Cancel a pending timer, does nothing if it is not pending.
+ *
+ * @param wheel Pointer to the timer_wheel_t.
+ * @param timer The timer index.
+ */
+void timer_wheel_cancel(timer_wheel_t* wheel, uint32_t timer);
+
+/**
+ * @brief Check if a timer is pending.
+ *
+ * @param wheel Pointer to the timer_wheel_t.
+ * @param timer The timer index.
+ * @return 1 if the timer is pending, 0 otherwise.
+ */
+int timer_wheel_pending(const timer_wheel_t* wheel, uint32_t timer);
+
+/**
+ * @brief Advance the wheel by one tick and fire every timer due on it. A timer is no longer pending when its
+ * callback runs, so the callback may schedule it again.
+ *
+ * @param wheel Pointer to the timer_wheel_t.
+ * @param fn Callback run for each timer that fires.
+ * @param userData Passed to the callback.
+ * @return The number of timers fired.
+ */
+uint32_t timer_wheel_advance(timer_wheel_t* wheel, timer_wheel_fire_fn fn, void* userData);
+
+#endif /* TIMER_WHEEL_H */
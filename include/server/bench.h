@@ -0,0 +1,27 @@
+#ifndef SERVER_BENCH_H
+#define SERVER_BENCH_H
+
+#include <stdint.h>
+
+#define BENCH_DEFAULT_TICKS 9000 // Five minutes of game time at the server tick rate
+#define BENCH_SEED 1337
+
+typedef struct bench_settings_s {
+    uint32_t ticks;
+    uint32_t workers;
+    uint32_t maxEntities;
+} bench_settings_t;
+
+/**
+ * @brief Run the headless simulation benchmark and print its results.
+ * @environment SERVER
+ *
+ * Loads the default world, places a fixed tower layout around a stash and runs waves through
+ * world_update and the entity think/update passes at a fixed timestep, with no network and no sleeping.
+ *
+ * @param settings The benchmark settings, zeroed fields fall back to defaults.
+ * @return 0 on success, -1 on failure.
+ */
+int server_bench_main(const bench_settings_t *settings);
+
+#endif /* SERVER_BENCH_H */
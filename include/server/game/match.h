@@ -0,0 +1,125 @@
+#ifndef SERVER_MATCH_H
+#define SERVER_MATCH_H
+
+#include <stdint.h>
+
+#include "common/buffer/ring.h"
+#include "common/game/entity.h"
+#include "common/game/game.h"
+#include "common/network/udp.h"
+#include "common/thread/condvar.h"
+#include "common/thread/mutex.h"
+#include "common/thread/thread.h"
+
+#define MATCH_MAX_PLAYERS 8
+#define MATCH_EVENT_QUEUE_SIZE 1024
+
+struct network_session_s;
+struct player_manager_s;
+struct tower_def_manager_s;
+struct worker_pool_s;
+
+typedef enum match_state_e {
+    MATCH_IDLE = 0,
+    MATCH_RUNNING = 1,
+    MATCH_SHUTDOWN_REQUESTED = 2,
+    MATCH_STOPPED = 3,
+} match_state_t;
+
+typedef struct match_s {
+    uint32_t id;
+    match_state_t state;
+    mutex_t lock;
+    thread_t thread;
+    uint8_t hasThread;
+    cond_t wakeCond; // Wakes a hibernating match, signaled with lock held
+    uint8_t hibernating;
+
+    game_t game; // Seed for the match thread's g_game, holds the shared definitions
+    struct tower_def_manager_s *towerDefs;
+    struct player_manager_s *playerManager;
+    struct worker_pool_s *workers;
+    buf_spsc_ring_t events; // Network events routed to this match, produced by the server thread
+
+    uint32_t numSessions;
+    uint8_t nextJoinTeamID;
+
+    double currentTps;
+    double currentUse;
+    double averageTps[20];
+    double averageUse[20];
+    entity_pool_stats_t entityStats; // Copied at the end of every tick for status reports
+} match_t;
+
+typedef struct match_manager_s {
+    match_t *matches;
+    uint32_t numMatches;
+
+    struct def_manager_s *defManager;
+    struct item_def_manager_s *itemDefManager;
+    struct tile_manager_s *tileManager;
+    struct enemy_def_manager_s *enemyManager;
+    struct tower_def_manager_s *towerDefs;
+} match_manager_t;
+
+/**
+ * @brief The match owned by the calling thread, NULL outside of a match tick thread.
+ */
+extern __thread match_t *g_match;
+
+/**
+ * @brief Load the shared definitions and start a tick thread for every match.
+ * @environment SERVER
+ *
+ * @param numMatches The number of matches to host.
+ * @param mode The game mode every match starts in.
+ * @param workers Worker pool for the parallel think phase, only used when hosting a single match.
+ * @return Pointer to the created manager, or NULL on failure.
+ */
+match_manager_t *match_manager_create(uint32_t numMatches, game_mode_t mode, struct worker_pool_s *workers);
+
+/**
+ * @brief Stop and join every match thread, then free the manager.
+ * @environment SERVER
+ *
+ * @param manager The match manager to destroy.
+ */
+void match_manager_destroy(match_manager_t *manager);
+
+/**
+ * @brief Pick the first running match that still has room for a session.
+ * @environment SERVER
+ *
+ * @param manager The match manager to route with.
+ * @param session The session to route, counted against the chosen match.
+ * @return The chosen match, or NULL if every match is full.
+ */
+match_t *match_manager_route(match_manager_t *manager, struct network_session_s *session);
+
+/**
+ * @brief Log the state and load of every match.
+ * @environment SERVER
+ *
+ * @param manager The match manager to report on.
+ */
+void match_manager_log_status(match_manager_t *manager);
+
+/**
+ * @brief Queue a network event for a match, ownership of any packet moves to the match.
+ * @environment SERVER
+ *
+ * @param match The match to queue the event for.
+ * @param event The event to queue.
+ * @return 1 on success, 0 if the match queue is full.
+ */
+int match_push_event(match_t *match, const net_udp_event_t *event);
+
+/**
+ * @brief Release a session from the match it was routed to.
+ * @environment SERVER
+ *
+ * @param match The match the session was routed to.
+ */
+void match_release_session(match_t *match);
+
+#endif /* SERVER_MATCH_H */
@@ -11,8 +11,10 @@
 
 typedef struct network_session_s {
     net_udp_peer_t *peer;
-    uint32_t sessionID;
+    uint32_t sessionID; // Index of the session slot in the server network
+    uint8_t inUse;
     struct player_s *player;
+    struct match_s *match; // Match the session was routed to, owns the session once set
 
     uint32_t dirtyFlags;
 
@@ -3,14 +3,18 @@
 
 #include "common/network/network.h"
 #include "common/network/udp.h"
+#include "common/thread/mutex.h"
+
+struct network_session_s;
 
 typedef struct server_network_s {
     network_t baseNetwork;
 
-    struct network_session_s *sessions;
+    struct network_session_s *sessions; // Fixed slots, a session's ID is its slot index
     size_t maxSessions;
     size_t currentSessionCount;
-    uint64_t nextSessionID;
+    mutex_t sessionLock; // Guards slot claims, sessions are released from match threads
+    mutex_t sendLock; // Serializes peer sends between match threads
 } server_network_t;
 
 server_network_t *server_network_create(const network_settings_t *settings);
@@ -19,5 +23,10 @@ void server_network_destroy(server_network_t *network);
 int server_network_start(server_network_t *network);
 void server_network_stop(server_network_t *network);
 void server_network_tick(server_network_t *network);
+int server_network_wait(server_network_t *network, uint32_t timeoutMs);
+size_t server_network_get_session_count(server_network_t *network);
+
+struct network_session_s *server_network_get_session(server_network_t *network, uint32_t sessionID);
+void server_network_session_close(server_network_t *network, struct network_session_s *session);
 
 #endif /* SERVER_NETWORK_H */
\ No newline at end of file
@@ -12,13 +12,17 @@
 extern uint8_t __DEBUG;
 extern uint8_t _dedicatedServer;
 
+struct match_manager_s;
 struct network_session_s;
 struct player_s;
-struct player_manager_s;
+struct worker_pool_s;
 
 #define SERVER_TARGET_TICKRATE 30
 #define SERVER_TARGET_SECONDS_PER_TICK (1.0 / SERVER_TARGET_TICKRATE)
 #define SERVER_TARGET_TICK_TIME_MS (1000.0 / SERVER_TARGET_TICKRATE)
+#define SERVER_MAX_SIM_WORKERS 7 // Background threads for the parallel think phase
+#define SERVER_MAX_MATCHES 64
+#define SERVER_HIBERNATE_WAIT_MS 500 // Longest a hibernating server blocks before rechecking for shutdown
 
 typedef enum ServerState_E {
     SERVER_IDLE = 0,
@@ -34,7 +38,8 @@ typedef struct Server_S {
     thread_t thread;
 
     struct server_network_s *network;
-    struct player_manager_s *playerManager;
+    struct match_manager_s *matchManager;
+    struct worker_pool_s *workers;
 
     double currentTps;
     double currentUse;
@@ -43,7 +48,8 @@ typedef struct Server_S {
 
     void (*onStart)(struct Server_S *server);
     game_mode_t startupMode;
-    uint8_t nextJoinTeamID;
+    uint32_t matchCount; // Matches hosted by this process, 0 is treated as 1
+    uint32_t maxEntities; // Entity limit per match, 0 uses ENTITY_DEFAULT_LIMIT
 } Server;
 
 extern Server g_server;
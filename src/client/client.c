@@ -2,6 +2,7 @@
 #include "gfc_input.h"
 
 #include "common/logger.h"
+#include "common/buffer/arena.h"
 #include "common/thread/mutex.h"
 #include "common/game/entity.h"
 #include "common/game/tower.h"
@@ -54,7 +55,7 @@ int client_main(int argc, char *argv[]) {
     gf2d_graphics_set_frame_delay(16);
     gf2d_sprite_init(1024);
     g_game.defManager = def_init(32);
-    g_game.entityManager = entity_init(1024*5);
+    g_game.entityManager = entity_init(ENTITY_DEFAULT_CAPACITY, ENTITY_DEFAULT_LIMIT);
     g_game.itemDefManager = item_init(g_game.defManager, "def/items.json");
     g_game.towerManager = tower_init(tower_load_defs(g_game.defManager, "def/towers.json"), 128);
     g_game.enemyManager = enemy_load_defs(g_game.defManager, "def/enemies.json");
@@ -276,6 +277,7 @@ void client_tickLoop(Client* client) {
 
             entity_think_all(g_game.entityManager);
             entity_update_all(g_game.entityManager, g_game.deltaTime);
+            entity_flush_destroyed(g_game.entityManager);
 
             client_on_mouse(g_game.deltaTime);
             window_handle_keyboard();
@@ -294,6 +296,7 @@ void client_tickLoop(Client* client) {
 
         client_render(client, accumulator / dt);
         gf2d_graphics_next_frame();
+        buf_tick_reset();
     }
 }
 
@@ -7,6 +7,7 @@
 #include "client/editor/tile_mode.h"
 #include "client/ui/window.h"
 #include "common/logger.h"
+#include "common/buffer/arena.h"
 #include "common/render/gf2d_font.h"
 #include "common/render/gf2d_graphics.h"
 
@@ -89,6 +90,7 @@ void editor_tick_loop(Client* client) {
 
             entity_think_all(g_game.entityManager);
             entity_update_all(g_game.entityManager, g_game.deltaTime);
+            entity_flush_destroyed(g_game.entityManager);
 
             editor_on_mouse(g_game.deltaTime);
             window_handle_keyboard();
@@ -105,6 +107,7 @@ void editor_tick_loop(Client* client) {
 
         editor_render(client, accumulator / dt);
         gf2d_graphics_next_frame();
+        buf_tick_reset();
     }
 }
 
@@ -9,11 +9,24 @@
 
 void editor_camera_update(const entity_manager_t *manager, entity_t *entity, float deltaTime);
 
-struct entity_s * editor_camera_spawn(const GFC_Vector2D position) {
-    entity_t * entity = entity_new(g_game.entityManager, -1);
+static void editor_camera_update_batch(const entity_manager_t *manager, entity_t **ents, const uint32_t count, const float deltaTime) {
+    uint32_t i;
+    for (i = 0; i < count; i++) {
+        if (entity_batch_skip(ents[i])) continue;
+        editor_camera_update(manager, ents[i], deltaTime);
+    }
+}
 
-    entity->position = position;
-    entity->update = editor_camera_update;
+struct entity_s * editor_camera_spawn(const GFC_Vector2D position) {
+    static const entity_type_ops_t ops = {
+        .updateBatch = editor_camera_update_batch
+    };
+    entity_t * entity;
+
+    entity_register_type(ENTITY_TYPE_EDITOR_CAMERA, &ops);
+    entity = entity_new(g_game.entityManager, -1);
+    entity_set_position(g_game.entityManager, entity, position);
+    entity->type = ENTITY_TYPE_EDITOR_CAMERA;
 
     return entity;
 }
@@ -72,6 +72,7 @@ int tile_mode_process_mouse(tile_mode_t *tm, const uint32_t mouseButton) {
     }
 
     chunk->tiles[(int)(worldPos.y / TILE_SIZE) % CHUNK_TILE_SIZE][(int)(worldPos.x / TILE_SIZE) % CHUNK_TILE_SIZE] = tm->tileId;
+    world_refresh_tile(g_game.world, (int)(worldPos.x / TILE_SIZE), (int)(worldPos.y / TILE_SIZE));
     SDL_DestroyTexture(chunk->texture);
     chunk->texture = chunk_create_texture(chunk, gf2d_graphics_get_renderer());
 
@@ -85,9 +85,7 @@ int build_mode_handle_click(uint32_t mouseButton, int x, int y) {
     tower_request_data_t data;
     int towerSize;
     float halfFootprint;
-    int startTileX, startTileY, tx, ty;
-    GFC_Vector2D samplePos;
-    tile_t *tile;
+    int startTileX, startTileY;
 
     if (!build_mode) {
         return 0;
@@ -107,14 +105,9 @@ int build_mode_handle_click(uint32_t mouseButton, int x, int y) {
         halfFootprint = (towerSize * TILE_SIZE) / 2.0f;
         startTileX = (int)floorf((build_mode->position.x - halfFootprint) / TILE_SIZE);
         startTileY = (int)floorf((build_mode->position.y - halfFootprint) / TILE_SIZE);
-        for (tx = startTileX; tx < startTileX + towerSize; tx++) {
-            for (ty = startTileY; ty < startTileY + towerSize; ty++) {
-                samplePos = gfc_vector2d((tx + 0.5f) * TILE_SIZE, (ty + 0.5f) * TILE_SIZE);
-                tile = world_get_tile_at_position(g_game.world, samplePos, NULL);
-                if (!tile || !tile->properties.buildable) {
-                    return 0; // Can't build here, one or more covered tiles are not buildable
-                }
-            }
+        if (!world_tiles_have_flag(g_game.world, startTileX, startTileY, startTileX + towerSize - 1,
+            startTileY + towerSize - 1, TILE_FLAG_BUILDABLE)) {
+            return 0; // Can't build here, one or more covered tiles are not buildable
         }
 
         data.buildData.xPos = build_mode->position.x;
@@ -243,8 +243,7 @@ void handle_s2c_enemy_snapshot(const s2c_enemy_snapshot_packet_t *pkt, void *cli
             return;
         }
 
-        enemy->position.x = pkt->eventData.updateData.xPos;
-        enemy->position.y = pkt->eventData.updateData.yPos;
+        entity_set_position(g_game.entityManager, enemy, gfc_vector2d(pkt->eventData.updateData.xPos, pkt->eventData.updateData.yPos));
         enemy->rotation = pkt->eventData.updateData.rotation;
 
         enemy_state_t *state = (enemy_state_t *)enemy->data;
@@ -260,8 +259,43 @@ void handle_s2c_enemy_snapshot(const s2c_enemy_snapshot_packet_t *pkt, void *cli
             return;
         }
 
-        enemy->think = entity_free; // Mark enemy for removal
+        entity_queue_destroy(g_game.entityManager, enemy); // Queue enemy for removal
     } else {
         log_warn("Unknown enemy event ID: %u for enemy ID: %lld", pkt->eventID, pkt->enemyID);
     }
+}
+
+void handle_s2c_enemy_despawn_batch(const s2c_enemy_despawn_batch_packet_t *pkt, void *client) {
+    entity_t *enemy;
+    uint16_t i;
+    if (!pkt) {
+        return;
+    }
+
+    for (i = 0; i < pkt->count; i++) {
+        enemy = entity_get(g_game.entityManager, pkt->enemyIDs[i]);
+        if (!enemy) {
+            log_error("Received despawn event for non-existent enemy ID: %lld", pkt->enemyIDs[i]);
+            continue;
+        }
+
+        entity_queue_destroy(g_game.entityManager, enemy);
+    }
+}
+
+void handle_s2c_enemy_damage_batch(const s2c_enemy_damage_batch_packet_t *pkt, void *client) {
+    entity_t *enemy;
+    uint16_t i;
+    if (!pkt) {
+        return;
+    }
+
+    for (i = 0; i < pkt->count; i++) {
+        enemy = entity_get(g_game.entityManager, pkt->entries[i].enemyID);
+        if (!enemy || !enemy->data) {
+            continue; // Despawned before the batch arrived
+        }
+
+        ((enemy_state_t *)enemy->data)->health = pkt->entries[i].health;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/buffer/arena.h"
+
+static __thread buf_arena_t t_tickArena;
+
+static buf_arena_block_t *buf_arena_block_create(const size_t capacity) {
+    buf_arena_block_t *block = malloc(sizeof(buf_arena_block_t) + capacity);
+    if (!block) {
+        return NULL;
+    }
+
+    block->next = NULL;
+    block->capacity = capacity;
+    block->offset = 0;
+    return block;
+}
+
+int buf_arena_init(buf_arena_t* arena, const size_t block_size) {
+    if (!arena || block_size == 0) {
+        return 0;
+    }
+
+    memset(arena, 0, sizeof(buf_arena_t));
+    arena->head = buf_arena_block_create(block_size);
+    if (!arena->head) {
+        return 0;
+    }
+
+    arena->block_size = block_size;
+    return 1;
+}
+
+void buf_arena_destroy(buf_arena_t* arena) {
+    buf_arena_block_t *block, *next;
+    if (!arena) {
+        return;
+    }
+
+    for (block = arena->head; block; block = next) {
+        next = block->next;
+        free(block);
+    }
+    memset(arena, 0, sizeof(buf_arena_t));
+}
+
+void *buf_arena_alloc(buf_arena_t* arena, size_t size) {
+    buf_arena_block_t *block;
+    void *ptr;
+    if (!arena || !arena->head) {
+        return NULL;
+    }
+
+    size = (size + BUF_ARENA_ALIGN - 1) & ~(size_t) (BUF_ARENA_ALIGN - 1);
+    block = arena->head;
+    if (block->offset + size > block->capacity) {
+        // Chain a new block, earlier allocations stay where they are until the reset
+        block = buf_arena_block_create(size > arena->block_size ? size : arena->block_size);
+        if (!block) {
+            return NULL;
+        }
+        block->next = arena->head;
+        arena->head = block;
+    }
+
+    ptr = block->data + block->offset;
+    block->offset += size;
+    arena->used += size;
+    memset(ptr, 0, size);
+
+    return ptr;
+}
+
+void buf_arena_reset(buf_arena_t* arena) {
+    buf_arena_block_t *merged, *next;
+    if (!arena || !arena->head) {
+        return;
+    }
+
+    if (arena->used > arena->peak) {
+        arena->peak = arena->used;
+    }
+    arena->used = 0;
+
+    if (!arena->head->next) {
+        arena->head->offset = 0;
+        return;
+    }
+
+    // Overflowed this cycle, replace the chain with one block that fits the peak
+    merged = buf_arena_block_create(arena->peak > arena->block_size ? arena->peak : arena->block_size);
+    if (!merged) {
+        // Out of memory, keep the newest block and drop the rest
+        merged = arena->head;
+        arena->head = merged->next;
+        merged->next = NULL;
+        merged->offset = 0;
+    }
+
+    while (arena->head) {
+        next = arena->head->next;
+        free(arena->head);
+        arena->head = next;
+    }
+    arena->head = merged;
+    arena->block_size = merged->capacity;
+}
+
+void *buf_tick_alloc(const size_t size) {
+    if (!t_tickArena.head && !buf_arena_init(&t_tickArena, BUF_TICK_ARENA_BLOCK_SIZE)) {
+        return NULL;
+    }
+
+    return buf_arena_alloc(&t_tickArena, size);
+}
+
+void buf_tick_reset(void) {
+    buf_arena_reset(&t_tickArena);
+}
+
+void buf_tick_close(void) {
+    buf_arena_destroy(&t_tickArena);
+}
+
+const buf_arena_t *buf_tick_arena(void) {
+    return &t_tickArena;
+}
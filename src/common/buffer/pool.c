@@ -0,0 +1,79 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/buffer/pool.h"
+
+int buf_pool_init(buf_pool_t* pool, const uint32_t capacity, const uint32_t item_size) {
+    uint32_t i;
+    if (!pool || capacity == 0 || item_size == 0) {
+        return 0;
+    }
+
+    memset(pool, 0, sizeof(buf_pool_t));
+    pool->item_size = (item_size + BUF_POOL_ALIGN - 1) & ~(uint32_t) (BUF_POOL_ALIGN - 1);
+    pool->buffer = malloc((size_t) capacity * pool->item_size);
+    if (!pool->buffer) {
+        return 0;
+    }
+    memset(pool->buffer, 0, (size_t) capacity * pool->item_size); // Fault every page in now rather than mid tick
+
+    // Link back to front so the lowest items are handed out first
+    for (i = capacity; i > 0; i--) {
+        void *item = (uint8_t*)pool->buffer + ((size_t) (i - 1) * pool->item_size);
+        *(void **)item = pool->freeHead;
+        pool->freeHead = item;
+    }
+    pool->capacity = capacity;
+
+    return 1;
+}
+
+void buf_pool_destroy(buf_pool_t* pool) {
+    if (pool && pool->buffer) {
+        free(pool->buffer);
+        memset(pool, 0, sizeof(buf_pool_t));
+    }
+}
+
+void *buf_pool_alloc(buf_pool_t* pool) {
+    void *item;
+    if (!pool) {
+        return NULL;
+    }
+
+    item = pool->freeHead;
+    if (!item) {
+        pool->overflows++;
+        return NULL; // Pool is empty
+    }
+
+    pool->freeHead = *(void **)item;
+    memset(item, 0, pool->item_size);
+    if (++pool->count > pool->peak) {
+        pool->peak = pool->count;
+    }
+
+    return item;
+}
+
+int buf_pool_free(buf_pool_t* pool, void* item) {
+    if (!buf_pool_owns(pool, item)) {
+        return 0;
+    }
+
+    *(void **)item = pool->freeHead;
+    pool->freeHead = item;
+    pool->count--;
+
+    return 1;
+}
+
+int buf_pool_owns(const buf_pool_t* pool, const void* item) {
+    const uint8_t *start;
+    if (!pool || !pool->buffer || !item) {
+        return 0;
+    }
+
+    start = (const uint8_t*)pool->buffer;
+    return (const uint8_t*)item >= start && (const uint8_t*)item < start + (size_t) pool->capacity * pool->item_size;
+}
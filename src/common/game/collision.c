@@ -1,15 +1,22 @@
 #include "common/game/collision.h"
 
+#include <string.h>
+
 #include "common/logger.h"
+#include "common/game/collision_batch.h"
+#include "common/game/game.h"
 #include "common/game/world/chunk.h"
 
+// Index of the first hit left in a kernel mask, the mask must not be 0
+#define collision_first_hit(mask) ((uint32_t) __builtin_ctz(mask))
+
 int collision_check(const entity_t *a, const entity_t *b) {
     GFC_Rect aBoundingBox, bBoundingBox;
     if (!a || !b) {
         return 0;
     }
 
-    if (!a->collidesWith || !(a->collidesWith(a, b) & COLLISION_SOLID)) {
+    if (!(entity_collides_with((entity_t *)a, (entity_t *)b) & COLLISION_SOLID)) {
         return 0; // No collision if a doesn't collide with b
     }
 
@@ -27,40 +34,119 @@ int collision_check(const entity_t *a, const entity_t *b) {
     return 1; // Collision detected
 }
 
-int collision_check_chunk(const chunk_t *chunk, const entity_t *ent, GFC_Vector2D newPosition) {
-    size_t i, j;
-    entity_t *otherEnt;
-    GFC_Rect aBoundingBox, bBoundingBox;
-    uint32_t collisionType, collided = 0;
-    if (!chunk || !ent) {
-        return 0;
+
+// Walks the static entities of a range of chunks, then the moving entities of the grid cells around an area.
+// Only the layer buckets selected by bucketMask are read
+typedef struct collision_walk_s {
+    const world_t *world;
+    int chunkX0, chunkY0, chunkX1, chunkY1;
+    int cellX0, cellY0, cellX1, cellY1;
+    int x, y;
+    uint8_t inGrid;
+    uint8_t hasCells;
+    uint32_t bucketMask;
+    const layer_buckets_t *current; // Container being read
+    uint32_t bucket; // Next bucket of the current container
+} collision_walk_t;
+
+static void collision_walk_begin(collision_walk_t *walk, const world_t *world, const uint32_t layerMask, const int chunkX0,
+    const int chunkY0, const int chunkX1, const int chunkY1, const float minX, const float minY, const float maxX, const float maxY) {
+    walk->world = world;
+    walk->chunkX0 = chunkX0;
+    walk->chunkY0 = chunkY0;
+    walk->chunkX1 = chunkX1;
+    walk->chunkY1 = chunkY1;
+    walk->hasCells = grid_cell_range(&world->grid, minX, minY, maxX, maxY,
+        &walk->cellX0, &walk->cellY0, &walk->cellX1, &walk->cellY1);
+    walk->inGrid = 0;
+    walk->x = chunkX0;
+    walk->y = chunkY0;
+    walk->bucketMask = layer_buckets_mask(layerMask);
+    walk->current = NULL;
+    walk->bucket = 0;
+}
+
+static const layer_buckets_t *collision_walk_next_container(collision_walk_t *walk) {
+    const chunk_t *chunk;
+    const grid_cell_t *cell;
+
+    while (!walk->inGrid) {
+        if (walk->x > walk->chunkX1 || walk->y > walk->chunkY1) {
+            walk->inGrid = 1;
+            walk->x = walk->cellX0;
+            walk->y = walk->cellY0;
+            break;
+        }
+
+        chunk = world_get_chunk(walk->world, walk->x, walk->y);
+        if (++walk->y > walk->chunkY1) {
+            walk->y = walk->chunkY0;
+            walk->x++;
+        }
+        if (chunk && chunk->entities.count) {
+            return &chunk->entities;
+        }
     }
 
-    for (i = 0; i < gfc_list_count(chunk->entities); i++) {
-        otherEnt = gfc_list_get_nth(chunk->entities, i);
-        if (otherEnt == ent) continue; // Skip self
-        if (!ent->collidesWith) continue; // Skip if not collidable
-        collisionType = ent->collidesWith(ent, otherEnt);
-        if (!collisionType) continue; // Skip if collidesWith returns no collision
+    if (!walk->hasCells) return NULL;
 
-        aBoundingBox = ent->boundingBox;
-        bBoundingBox = otherEnt->boundingBox;
-        aBoundingBox.x += newPosition.x;
-        aBoundingBox.y += newPosition.y;
-        bBoundingBox.x += otherEnt->position.x;
-        bBoundingBox.y += otherEnt->position.y;
+    // Row by row, the order cells are laid out in
+    while (walk->y <= walk->cellY1) {
+        cell = grid_get_cell(&walk->world->grid, walk->x, walk->y);
+        if (++walk->x > walk->cellX1) {
+            walk->x = walk->cellX0;
+            walk->y++;
+        }
+        if (cell && cell->count) {
+            return cell;
+        }
+    }
+
+    return NULL;
+}
+
+static int collision_walk_next(collision_walk_t *walk, const uint32_t **slots, uint32_t *count) {
+    for (;;) {
+        if (walk->current && layer_buckets_next_span(walk->current, walk->bucketMask, &walk->bucket, slots, count)) {
+            return 1;
+        }
+
+        walk->current = collision_walk_next_container(walk);
+        walk->bucket = 0;
+        if (!walk->current) return 0;
+    }
+}
+
+// onCollide handlers defer frees and moves, the slot array cannot change under the loop
+static int collision_check_slots(const entity_hot_t *hot, const uint32_t *slots, const uint32_t count, const entity_t *ent,
+    const float minX, const float minY, const float maxX, const float maxY) {
+    collision_batch_t batch;
+    entity_t *otherEnt;
+    uint32_t base, i, slot, hits, collisionType, collided = 0;
+
+    for (base = 0; base < count; base += batch.count) {
+        // Bounds come from the hot arrays, the entity itself is only touched on overlap
+        collision_batch_gather(&batch, hot, slots + base, count - base, COLLISION_BATCH_BOUNDS);
+        hits = collision_batch_overlap_rect(&batch, minX, minY, maxX, maxY);
+
+        // Lowest bit first keeps the order of the slot array
+        for (; hits; hits &= hits - 1) {
+            i = collision_first_hit(hits);
+            slot = batch.slots[i];
+            if (slot == ent->_slot) continue; // Skip self
+
+            otherEnt = entity_from_slot(g_game.entityManager, slot);
+            collisionType = entity_collides_with((entity_t *)ent, otherEnt);
+            if (!collisionType) continue; // Skip if collidesWith returns no collision
 
-        if (gfc_rect_overlap(aBoundingBox, bBoundingBox)) {
             if (collisionType & COLLISION_SOLID) {
-                if (ent->onCollide && !ent->onCollide(ent, otherEnt, collisionType)) {
+                if (!entity_on_collide((entity_t *)ent, otherEnt, collisionType)) {
                     continue;
                 }
                 return 1; // Collision detected, cannot move
             }
 
-            if (ent->onCollide) {
-                ent->onCollide(ent, otherEnt, collisionType);
-            }
+            entity_on_collide((entity_t *)ent, otherEnt, collisionType);
             // If it's not a solid collision, we still want to trigger the onCollide event, but it doesn't block movement
             collided = 1;
         }
@@ -71,172 +157,469 @@ int collision_check_chunk(const chunk_t *chunk, const entity_t *ent, GFC_Vector2
 
 int collision_check_world(const world_t *world, const entity_t *ent,
     GFC_Vector2D newPosition) {
-    int chunkX, chunkY, i, j;
-    chunk_t *chunk;
-    if (!world || !ent) {
+    collision_walk_t walk;
+    const entity_hot_t *hot = entity_get_hot(g_game.entityManager);
+    const uint32_t *slots;
+    uint32_t count;
+    float minX, minY, maxX, maxY;
+    int chunkX, chunkY;
+    if (!world || !ent || !hot) {
         return 0;
     }
 
+    minX = newPosition.x + ent->boundingBox.x;
+    minY = newPosition.y + ent->boundingBox.y;
+    maxX = minX + ent->boundingBox.w;
+    maxY = minY + ent->boundingBox.h;
+
     chunkX = pos_to_chunk_coord(newPosition.x);
     chunkY = pos_to_chunk_coord(newPosition.y);
-    for (i = chunkX - 1; i <= chunkX + 1; i++) {
-        for (j = chunkY - 1; j <= chunkY + 1; j++) {
-            chunk = world_get_chunk(world, i, j);
-            if (!chunk) continue;
-            if (collision_check_chunk(chunk, ent, newPosition)) {
-                return 1; // Collision detected in this chunk, cannot move
-            }
+    collision_walk_begin(&walk, world, 0, chunkX - 1, chunkY - 1, chunkX + 1, chunkY + 1, minX, minY, maxX, maxY);
+    while (collision_walk_next(&walk, &slots, &count)) {
+        if (collision_check_slots(hot, slots, count, ent, minX, minY, maxX, maxY)) {
+            return 1; // Collision detected, cannot move
         }
     }
 
     return 0;
 }
 
-int collision_check_chunk_bounding(const chunk_t *chunk, GFC_Rect boundingBox) {
-    size_t i, j;
-    entity_t *otherEnt;
-    GFC_Rect otherBoundingBox;
-    if (!chunk) {
+int collision_check_world_bounding(const world_t *world, GFC_Rect boundingBox) {
+    collision_walk_t walk;
+    collision_batch_t batch;
+    const entity_hot_t *hot = entity_get_hot(g_game.entityManager);
+    const uint32_t *slots;
+    uint32_t base, count;
+    float maxX, maxY;
+    if (!world || !hot) {
         return 0;
     }
 
-    for (i = 0; i < gfc_list_count(chunk->entities); i++) {
-        otherEnt = gfc_list_get_nth(chunk->entities, i);
+    maxX = boundingBox.x + boundingBox.w;
+    maxY = boundingBox.y + boundingBox.h;
+    collision_walk_begin(&walk, world, 0, pos_to_chunk_coord(boundingBox.x), pos_to_chunk_coord(boundingBox.y),
+        pos_to_chunk_coord(maxX), pos_to_chunk_coord(maxY), boundingBox.x, boundingBox.y, maxX, maxY);
+    while (collision_walk_next(&walk, &slots, &count)) {
+        for (base = 0; base < count; base += batch.count) {
+            collision_batch_gather(&batch, hot, slots + base, count - base, COLLISION_BATCH_BOUNDS);
+            if (collision_batch_overlap_rect(&batch, boundingBox.x, boundingBox.y, maxX, maxY)) {
+                return 0; // Collision detected, bounding box is not clear
+            }
+        }
+    }
+
+    return 1; // No collision detected, bounding box is clear
+}
 
-        otherBoundingBox = otherEnt->boundingBox;
-        otherBoundingBox.x += otherEnt->position.x;
-        otherBoundingBox.y += otherEnt->position.y;
+typedef struct collision_shape_s {
+    float minX, minY, maxX, maxY; // Bounds of the circle
+    GFC_Vector2D center;
+    float radiusSq;
+} collision_shape_t;
+
+// Applies the filter to a candidate that passed the shape test, the entity is only resolved if its layer matches
+static entity_t *collision_filter_accept(const collision_filter_t *filter, const entity_hot_t *hot, const uint32_t slot,
+    const uint32_t row) {
+    entity_t *ent;
+
+    if (filter->source && slot == filter->source->_slot) return NULL;
+    // Walks already skip other layers' buckets, the layer test is for the mixed bucket
+    if (filter->layerMask && !(hot->layers[row] & filter->layerMask)) return NULL;
+
+    ent = entity_from_slot(g_game.entityManager, slot);
+    if (!ent) return NULL;
+    if (filter->typeMask && !(filter->typeMask & COLLISION_TYPE_BIT(ent->type))) return NULL;
+    if (filter->solidOnly && !(entity_collides_with((entity_t *)filter->source, ent) & COLLISION_SOLID)) return NULL;
+    return ent;
+}
 
-        if (gfc_rect_overlap(boundingBox, otherBoundingBox)) {
-            return 0; // Collision detected, bounding box is not clear
+static uint32_t collision_visit_shape(const world_t *world, const collision_shape_t *shape, const collision_filter_t *filter,
+    const collision_visit_fn fn, void *userData) {
+    static const collision_filter_t matchAll = {0};
+    collision_walk_t walk;
+    collision_batch_t batch;
+    const entity_hot_t *hot = entity_get_hot(g_game.entityManager);
+    const uint32_t *slots;
+    entity_t *ent;
+    uint32_t base, i, count, hits, visited = 0;
+    if (!world || !hot) {
+        return 0;
+    }
+    if (!filter) filter = &matchAll;
+
+    collision_walk_begin(&walk, world, filter->layerMask, pos_to_chunk_coord(shape->minX), pos_to_chunk_coord(shape->minY),
+        pos_to_chunk_coord(shape->maxX), pos_to_chunk_coord(shape->maxY), shape->minX, shape->minY, shape->maxX, shape->maxY);
+    while (collision_walk_next(&walk, &slots, &count)) {
+        for (base = 0; base < count; base += batch.count) {
+            // Shape and layer tests read the hot arrays, the entity is only resolved once both pass
+            collision_batch_gather(&batch, hot, slots + base, count - base, COLLISION_BATCH_CENTERS);
+            for (hits = collision_batch_inside_circle(&batch, shape->center.x, shape->center.y, shape->radiusSq); hits;
+                hits &= hits - 1) {
+                i = collision_first_hit(hits);
+                ent = collision_filter_accept(filter, hot, batch.slots[i], batch.rows[i]);
+                if (!ent) continue;
+
+                visited++;
+                if (fn && !fn(ent, userData)) {
+                    return visited;
+                }
+            }
         }
     }
 
-    return 1; // No collision detected, bounding box is clear
+    return visited;
 }
 
-int collision_check_world_bounding(const world_t *world, GFC_Rect boundingBox) {
-    int chunkXStart, chunkYStart, chunkXEnd, chunkYEnd, i, j;
-    chunk_t *chunk;
-    if (!world) {
+static void collision_shape_circle(collision_shape_t *shape, const GFC_Vector2D center, const float radius) {
+    shape->minX = center.x - radius;
+    shape->minY = center.y - radius;
+    shape->maxX = center.x + radius;
+    shape->maxY = center.y + radius;
+    shape->center = center;
+    shape->radiusSq = radius * radius;
+}
+
+uint32_t collision_visit_circle(const world_t *world, const GFC_Vector2D center, const float radius, const collision_filter_t *filter,
+    const collision_visit_fn fn, void *userData) {
+    collision_shape_t shape;
+    collision_shape_circle(&shape, center, radius);
+    return collision_visit_shape(world, &shape, filter, fn, userData);
+}
+
+uint32_t collision_visit_circles(const world_t *world, const collision_circle_t *circles, uint32_t count,
+    const collision_filter_t *filter, const collision_visit_circles_fn fn, void *userData) {
+    static const collision_filter_t matchAll = {0};
+    collision_walk_t walk;
+    collision_batch_t batch;
+    const entity_hot_t *hot = entity_get_hot(g_game.entityManager);
+    const uint32_t *slots;
+    entity_t *ent;
+    uint32_t circleMasks[COLLISION_BATCH_SIZE];
+    uint32_t base, i, k, spanCount, hits, visited = 0;
+    float minX, minY, maxX, maxY;
+    if (!world || !hot || !circles || count == 0) {
         return 0;
     }
+    if (!filter) filter = &matchAll;
+    if (count > COLLISION_MAX_CIRCLES) count = COLLISION_MAX_CIRCLES;
+
+    minX = circles[0].center.x - circles[0].radius;
+    minY = circles[0].center.y - circles[0].radius;
+    maxX = circles[0].center.x + circles[0].radius;
+    maxY = circles[0].center.y + circles[0].radius;
+    for (k = 1; k < count; k++) {
+        minX = fminf(minX, circles[k].center.x - circles[k].radius);
+        minY = fminf(minY, circles[k].center.y - circles[k].radius);
+        maxX = fmaxf(maxX, circles[k].center.x + circles[k].radius);
+        maxY = fmaxf(maxY, circles[k].center.y + circles[k].radius);
+    }
 
-    chunkXStart = pos_to_chunk_coord(boundingBox.x);
-    chunkYStart = pos_to_chunk_coord(boundingBox.y);
-    chunkXEnd = pos_to_chunk_coord(boundingBox.x + boundingBox.w);
-    chunkYEnd = pos_to_chunk_coord(boundingBox.y + boundingBox.h);
+    collision_walk_begin(&walk, world, filter->layerMask, pos_to_chunk_coord(minX), pos_to_chunk_coord(minY),
+        pos_to_chunk_coord(maxX), pos_to_chunk_coord(maxY), minX, minY, maxX, maxY);
+    while (collision_walk_next(&walk, &slots, &spanCount)) {
+        for (base = 0; base < spanCount; base += batch.count) {
+            collision_batch_gather(&batch, hot, slots + base, spanCount - base, COLLISION_BATCH_CENTERS);
+
+            // Each circle is one kernel call over the batch, its hits are spread into per entry circle masks
+            memset(circleMasks, 0, sizeof(circleMasks));
+            for (k = 0; k < count; k++) {
+                for (hits = collision_batch_inside_circle(&batch, circles[k].center.x, circles[k].center.y,
+                    circles[k].radius * circles[k].radius); hits; hits &= hits - 1) {
+                    circleMasks[collision_first_hit(hits)] |= 1u << k;
+                }
+            }
 
-    for (i = chunkXStart; i <= chunkXEnd; i++) {
-        for (j = chunkYStart; j <= chunkYEnd; j++) {
-            chunk = world_get_chunk(world, i, j);
-            if (!chunk) continue;
+            for (i = 0; i < batch.count; i++) {
+                if (!circleMasks[i]) continue;
+                ent = collision_filter_accept(filter, hot, batch.slots[i], batch.rows[i]);
+                if (!ent) continue;
 
-            if (!collision_check_chunk_bounding(chunk, boundingBox)) {
-                return 0; // Collision detected in this chunk, bounding box is not clear
+                visited++;
+                if (fn && !fn(ent, circleMasks[i], userData)) {
+                    return visited;
+                }
             }
         }
     }
 
-    return 1; // No collision detected in surrounding chunks, bounding box is clear
+    return visited;
 }
 
-int collision_raycast_chunk(const chunk_t *chunk, const entity_t *ent, GFC_Edge2D ray, GFC_List *hits) {
-    size_t i, j;
-    entity_t *otherEnt;
-    GFC_Rect otherBoundingBox;
-    if (!chunk || !hits) {
-        return 0;
+// Cells of a uniform grid that can hold an entity whose bounding box the segment touches, given how far boxes reach
+// from their entity's position. Cells come one line across the segment's major axis at a time, in the direction of
+// travel, so they are reached roughly in the order the segment passes them.
+typedef struct collision_sweep_s {
+    int major; // 0 if the segment runs mostly along x, 1 if along y
+    float start[2];
+    float delta[2];
+    float cellSize;
+    float margin;
+    int size[2]; // Cells per axis
+    int line, lastLine, lineStep;
+    int minor, minorLast, minorStep; // Cells left in the current line
+    float lineFraction; // Nothing in the current line or any later one is hit before this fraction of the segment
+} collision_sweep_t;
+
+static int collision_sweep_clamp(const float pos, const float cellSize, const int size) {
+    int cell = (int) floorf(pos / cellSize);
+    if (cell < 0) return 0;
+    if (cell >= size) return size - 1;
+    return cell;
+}
+
+// Prepares the cells of the current line
+static void collision_sweep_line(collision_sweep_t *sweep) {
+    const int m = sweep->major, n = 1 - m;
+    float lo, hi, a, b, edge;
+
+    // Part of the segment whose boxes can reach the line, as a range along the minor axis
+    lo = sweep->line * sweep->cellSize - sweep->margin;
+    hi = (sweep->line + 1) * sweep->cellSize + sweep->margin;
+    if (sweep->delta[m] != 0.0f) {
+        a = (lo - sweep->start[m]) / sweep->delta[m];
+        b = (hi - sweep->start[m]) / sweep->delta[m];
+        a = fminf(fmaxf(a, 0.0f), 1.0f);
+        b = fminf(fmaxf(b, 0.0f), 1.0f);
+        lo = sweep->start[n] + a * sweep->delta[n];
+        hi = sweep->start[n] + b * sweep->delta[n];
+    } else {
+        lo = hi = sweep->start[n];
     }
 
-    for (i = 0; i < gfc_list_count(chunk->entities); i++) {
-        otherEnt = gfc_list_get_nth(chunk->entities, i);
+    sweep->minorStep = sweep->delta[n] < 0.0f ? -1 : 1;
+    sweep->minor = collision_sweep_clamp((sweep->minorStep > 0 ? fminf(lo, hi) : fmaxf(lo, hi)) - sweep->minorStep * sweep->margin,
+        sweep->cellSize, sweep->size[n]);
+    sweep->minorLast = collision_sweep_clamp((sweep->minorStep > 0 ? fmaxf(lo, hi) : fminf(lo, hi)) + sweep->minorStep * sweep->margin,
+        sweep->cellSize, sweep->size[n]);
+
+    // Boxes of this line's entities start no nearer than the line's near edge less the margin
+    edge = sweep->lineStep > 0 ? sweep->line * sweep->cellSize - sweep->margin : (sweep->line + 1) * sweep->cellSize + sweep->margin;
+    sweep->lineFraction = sweep->delta[m] != 0.0f ? fmaxf((edge - sweep->start[m]) / sweep->delta[m], 0.0f) : 0.0f;
+}
+
+static int collision_sweep_begin(collision_sweep_t *sweep, const GFC_Vector2D start, const GFC_Vector2D end, const float cellSize,
+    const int width, const int height, const float margin) {
+    int m;
+    if (width <= 0 || height <= 0 || cellSize <= 0.0f) {
+        return 0;
+    }
+    if (fmaxf(start.x, end.x) + margin < 0.0f || fmaxf(start.y, end.y) + margin < 0.0f ||
+        fminf(start.x, end.x) - margin >= width * cellSize || fminf(start.y, end.y) - margin >= height * cellSize) {
+        return 0; // Entirely outside the grid
+    }
 
-        if (otherEnt == ent) continue; // Skip self
-        if (!ent->collidesWith || !(ent->collidesWith(ent, otherEnt) & COLLISION_SOLID)) continue; // Skip if not collidable
+    sweep->start[0] = start.x;
+    sweep->start[1] = start.y;
+    sweep->delta[0] = end.x - start.x;
+    sweep->delta[1] = end.y - start.y;
+    sweep->major = m = fabsf(sweep->delta[0]) >= fabsf(sweep->delta[1]) ? 0 : 1;
+    sweep->cellSize = cellSize;
+    sweep->margin = margin;
+    sweep->size[0] = width;
+    sweep->size[1] = height;
+
+    sweep->lineStep = sweep->delta[m] < 0.0f ? -1 : 1;
+    sweep->line = collision_sweep_clamp(sweep->start[m] - sweep->lineStep * margin, cellSize, sweep->size[m]);
+    sweep->lastLine = collision_sweep_clamp(sweep->start[m] + sweep->delta[m] + sweep->lineStep * margin, cellSize, sweep->size[m]);
+    collision_sweep_line(sweep);
+    return 1;
+}
 
-        otherBoundingBox = otherEnt->boundingBox;
-        otherBoundingBox.x += otherEnt->position.x;
-        otherBoundingBox.y += otherEnt->position.y;
+static int collision_sweep_next(collision_sweep_t *sweep, int *x, int *y) {
+    int cell[2];
 
-        if (gfc_edge_rect_intersection(ray, otherBoundingBox)) {
-            gfc_list_append(hits, otherEnt);
+    if (sweep->minor == sweep->minorLast + sweep->minorStep) {
+        if (sweep->line == sweep->lastLine) {
+            return 0;
         }
+        sweep->line += sweep->lineStep;
+        collision_sweep_line(sweep);
     }
 
-    return 1; // Raycast completed for this chunk
+    cell[sweep->major] = sweep->line;
+    cell[1 - sweep->major] = sweep->minor;
+    sweep->minor += sweep->minorStep;
+    *x = cell[0];
+    *y = cell[1];
+    return 1;
 }
 
-int collision_raycast_world(const world_t *world, const entity_t *ent, GFC_Vector2D start, GFC_Vector2D end, GFC_List *hits) {
-    int chunkXStart, chunkYStart, chunkXEnd, chunkYEnd, i, j;
-    GFC_Edge2D edge;
-    chunk_t *chunk;
-    int hit = 0;
-    if (!world || !hits) {
-        return 0;
+// Fraction of the segment at which it enters a box, the start counts if it is inside
+static int collision_segment_enter(const float startX, const float startY, const float deltaX, const float deltaY,
+    const float minX, const float minY, const float maxX, const float maxY, float *fraction) {
+    const float start[2] = { startX, startY }, delta[2] = { deltaX, deltaY };
+    const float boxMin[2] = { minX, minY }, boxMax[2] = { maxX, maxY };
+    float enter = 0.0f, leave = 1.0f, a, b, swap;
+    int axis;
+
+    for (axis = 0; axis < 2; axis++) {
+        if (delta[axis] == 0.0f) {
+            if (start[axis] < boxMin[axis] || start[axis] > boxMax[axis]) return 0;
+            continue;
+        }
+        a = (boxMin[axis] - start[axis]) / delta[axis];
+        b = (boxMax[axis] - start[axis]) / delta[axis];
+        if (a > b) {
+            swap = a;
+            a = b;
+            b = swap;
+        }
+        if (a > enter) enter = a;
+        if (b < leave) leave = b;
+        if (enter > leave) return 0;
     }
 
-    chunkXStart = pos_to_chunk_coord(fminf(start.x, end.x));
-    chunkYStart = pos_to_chunk_coord(fminf(start.y, end.y));
-    chunkXEnd = pos_to_chunk_coord(fmaxf(start.x, end.x));
-    chunkYEnd = pos_to_chunk_coord(fmaxf(start.y, end.y));
+    *fraction = enter;
+    return 1;
+}
+
+// A segment query, either visiting every match or keeping the nearest one
+typedef struct collision_ray_s {
+    const entity_hot_t *hot;
+    const collision_filter_t *filter;
+    uint32_t bucketMask;
+    GFC_Vector2D start;
+    GFC_Vector2D delta;
+    float minX, minY, maxX, maxY; // Bounds of the segment
+    uint8_t nearestOnly; // Keep the nearest match instead of visiting
+    collision_visit_fn fn;
+    void *userData;
+    uint32_t visited;
+    uint8_t stopped;
+    entity_t *nearest;
+    float nearestFraction;
+} collision_ray_t;
+
+static void collision_ray_test(collision_ray_t *ray, const layer_buckets_t *container) {
+    collision_batch_t batch;
+    const uint32_t *slots;
+    entity_t *ent;
+    uint32_t bucket = 0, base, count, hits, i;
+    float fraction;
+
+    while (layer_buckets_next_span(container, ray->bucketMask, &bucket, &slots, &count)) {
+        for (base = 0; base < count; base += batch.count) {
+            // A box the segment's bounds miss cannot intersect the segment
+            collision_batch_gather(&batch, ray->hot, slots + base, count - base, COLLISION_BATCH_BOUNDS);
+            for (hits = collision_batch_overlap_rect(&batch, ray->minX, ray->minY, ray->maxX, ray->maxY); hits; hits &= hits - 1) {
+                i = collision_first_hit(hits);
+                if (!collision_segment_enter(ray->start.x, ray->start.y, ray->delta.x, ray->delta.y,
+                    batch.minX[i], batch.minY[i], batch.maxX[i], batch.maxY[i], &fraction)) {
+                    continue;
+                }
+                if (ray->nearestOnly && ray->nearest && fraction >= ray->nearestFraction) continue;
 
-    edge = gfc_edge_from_vectors(start, end);
+                ent = collision_filter_accept(ray->filter, ray->hot, batch.slots[i], batch.rows[i]);
+                if (!ent) continue;
 
-    for (i = chunkXStart; i <= chunkXEnd; i++) {
-        for (j = chunkYStart; j <= chunkYEnd; j++) {
-            chunk = world_get_chunk(world, i, j);
-            if (!chunk) continue;
-            if (collision_raycast_chunk(chunk, ent, edge, hits)) {
-                hit = 1; // At least one hit detected in this chunk
+                if (ray->nearestOnly) {
+                    ray->nearest = ent;
+                    ray->nearestFraction = fraction;
+                    continue;
+                }
+                ray->visited++;
+                if (ray->fn && !ray->fn(ent, ray->userData)) {
+                    ray->stopped = 1;
+                    return;
+                }
             }
         }
     }
-
-    return hit; // Return whether any hits were detected across all chunks
 }
 
-void collision_get_entities_in_range_chunk(const chunk_t *chunk, GFC_Circle bounding, uint32_t layerMask, GFC_List *entitiesInRange) {
-    size_t i, j;
-    entity_t *otherEnt;
-    if (!chunk || !entitiesInRange) {
+static void collision_ray_sweep(collision_ray_t *ray, const world_t *world, const uint8_t grid) {
+    collision_sweep_t sweep;
+    const layer_buckets_t *container;
+    const chunk_t *chunk;
+    GFC_Vector2D end;
+    int x, y, ok;
+
+    gfc_vector2d_add(end, ray->start, ray->delta);
+    if (grid) {
+        ok = collision_sweep_begin(&sweep, ray->start, end, world->grid.cellSize, world->grid.width, world->grid.height,
+            world->grid.margin);
+    } else {
+        ok = collision_sweep_begin(&sweep, ray->start, end, CHUNK_TILE_SIZE * TILE_SIZE, world->size.x, world->size.y,
+            world->chunkMargin);
+    }
+    if (!ok) {
         return;
     }
 
-    for (i = 0; i < gfc_list_count(chunk->entities); i++) {
-        otherEnt = gfc_list_get_nth(chunk->entities, i);
-
-        if (!(otherEnt->layers & layerMask)) continue; // Skip if not in layer mask
+    while (!ray->stopped && collision_sweep_next(&sweep, &x, &y)) {
+        if (ray->nearestOnly && ray->nearest && sweep.lineFraction >= ray->nearestFraction) {
+            return; // Nothing left can be nearer
+        }
 
-        if (gfc_point_in_cicle(otherEnt->position, bounding)) {
-            gfc_list_append(entitiesInRange, otherEnt);
+        if (grid) {
+            container = grid_get_cell(&world->grid, x, y);
+        } else {
+            chunk = world_get_chunk(world, x, y);
+            container = chunk ? &chunk->entities : NULL;
+        }
+        if (container && container->count) {
+            collision_ray_test(ray, container);
         }
     }
 }
 
-GFC_List * collision_get_entities_in_range(const world_t *world, GFC_Vector2D position, float range,
-    uint32_t layerMask) {
-    int chunkXStart, chunkYStart, chunkXEnd, chunkYEnd, i, j;
-    chunk_t *chunk;
-    GFC_List *entitiesInRange;
+static int collision_ray_begin(collision_ray_t *ray, const world_t *world, const GFC_Vector2D start, const GFC_Vector2D end,
+    const collision_filter_t *filter) {
+    static const collision_filter_t matchAll = {0};
     if (!world) {
-        return NULL;
+        return 0;
+    }
+
+    memset(ray, 0, sizeof(collision_ray_t));
+    ray->hot = entity_get_hot(g_game.entityManager);
+    if (!ray->hot) {
+        return 0;
     }
+    ray->filter = filter ? filter : &matchAll;
+    ray->bucketMask = layer_buckets_mask(ray->filter->layerMask);
+    ray->start = start;
+    gfc_vector2d_sub(ray->delta, end, start);
+    ray->minX = fminf(start.x, end.x);
+    ray->minY = fminf(start.y, end.y);
+    ray->maxX = fmaxf(start.x, end.x);
+    ray->maxY = fmaxf(start.y, end.y);
+    return 1;
+}
 
-    chunkXStart = pos_to_chunk_coord(position.x - range);
-    chunkYStart = pos_to_chunk_coord(position.y - range);
-    chunkXEnd = pos_to_chunk_coord(position.x + range);
-    chunkYEnd = pos_to_chunk_coord(position.y + range);
+uint32_t collision_visit_segment(const world_t *world, const GFC_Vector2D start, const GFC_Vector2D end, const collision_filter_t *filter,
+    const collision_visit_fn fn, void *userData) {
+    collision_ray_t ray;
+    if (!collision_ray_begin(&ray, world, start, end, filter)) {
+        return 0;
+    }
 
-    entitiesInRange = gfc_list_new();
-    GFC_Circle rangeCircle = gfc_circle(position.x, position.y, range);
-    for (i = chunkXStart; i <= chunkXEnd; i++) {
-        for (j = chunkYStart; j <= chunkYEnd; j++) {
-            chunk = world_get_chunk(world, i, j);
-            if (!chunk) continue;
-            collision_get_entities_in_range_chunk(chunk, rangeCircle, layerMask, entitiesInRange);
-        }
+    ray.fn = fn;
+    ray.userData = userData;
+    collision_ray_sweep(&ray, world, 0);
+    collision_ray_sweep(&ray, world, 1);
+    return ray.visited;
+}
+
+int collision_raycast(const world_t *world, const GFC_Vector2D start, const GFC_Vector2D end, const collision_filter_t *filter,
+    collision_hit_t *hit) {
+    collision_ray_t ray;
+    if (!collision_ray_begin(&ray, world, start, end, filter)) {
+        return 0;
+    }
+
+    ray.nearestOnly = 1;
+    collision_ray_sweep(&ray, world, 0);
+    collision_ray_sweep(&ray, world, 1);
+    if (!ray.nearest) {
+        return 0;
     }
 
-    return entitiesInRange;
+    if (hit) {
+        hit->entity = ray.nearest;
+        hit->fraction = ray.nearestFraction;
+        hit->point = gfc_vector2d(start.x + ray.delta.x * ray.nearestFraction, start.y + ray.delta.y * ray.nearestFraction);
+        hit->tile.x = (int) floorf(hit->point.x / TILE_SIZE);
+        hit->tile.y = (int) floorf(hit->point.y / TILE_SIZE);
+    }
+    return 1;
 }
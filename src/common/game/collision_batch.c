@@ -0,0 +1,141 @@
+#include "common/game/collision_batch.h"
+
+// The widest instruction set the compiler targets is picked at build time, -mavx or -march=native enables 8 lanes
+#if defined(__AVX__)
+#include <immintrin.h>
+#define COLLISION_BATCH_LANES 8
+#elif defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define COLLISION_BATCH_LANES 4
+#else
+#define COLLISION_BATCH_LANES 1
+#endif
+
+#if COLLISION_BATCH_SIZE % 8 != 0 || COLLISION_BATCH_SIZE > 32
+#error "COLLISION_BATCH_SIZE must be a multiple of 8 that fits a 32 bit hit mask"
+#endif
+
+static uint32_t collision_batch_live_mask(const uint32_t count) {
+    return count >= 32 ? UINT32_MAX : (1u << count) - 1;
+}
+
+uint32_t collision_batch_gather(collision_batch_t *batch, const entity_hot_t *hot, const uint32_t *slots, uint32_t count,
+    const uint32_t fields) {
+    uint32_t i, row, padded;
+    if (!batch || !hot || !slots) {
+        return 0;
+    }
+
+    if (count > COLLISION_BATCH_SIZE) count = COLLISION_BATCH_SIZE;
+    for (i = 0; i < count; i++) {
+        row = hot->rows[slots[i]];
+        batch->slots[i] = slots[i];
+        batch->rows[i] = row;
+        if (fields & COLLISION_BATCH_BOUNDS) {
+            batch->minX[i] = hot->minX[row];
+            batch->minY[i] = hot->minY[row];
+            batch->maxX[i] = hot->maxX[row];
+            batch->maxY[i] = hot->maxY[row];
+        }
+        if (fields & COLLISION_BATCH_CENTERS) {
+            batch->posX[i] = hot->posX[row];
+            batch->posY[i] = hot->posY[row];
+        }
+    }
+
+    // Kernels read whole vectors, padding keeps the lanes past count initialized. Their bits are masked off
+    padded = (count + 7) & ~7u;
+    for (; i < padded; i++) {
+        batch->minX[i] = batch->minY[i] = batch->maxX[i] = batch->maxY[i] = 0.0f;
+        batch->posX[i] = batch->posY[i] = 0.0f;
+    }
+
+    batch->count = count;
+    return count;
+}
+
+uint32_t collision_batch_overlap_rect(const collision_batch_t *batch, const float minX, const float minY, const float maxX,
+    const float maxY) {
+    uint32_t i, mask = 0;
+    if (!batch) {
+        return 0;
+    }
+
+#if COLLISION_BATCH_LANES == 8
+    const __m256 qMinX = _mm256_set1_ps(minX), qMinY = _mm256_set1_ps(minY);
+    const __m256 qMaxX = _mm256_set1_ps(maxX), qMaxY = _mm256_set1_ps(maxY);
+    __m256 hit;
+    for (i = 0; i < batch->count; i += 8) {
+        hit = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(batch->minX + i), qMaxX, _CMP_LE_OQ),
+            _mm256_cmp_ps(_mm256_loadu_ps(batch->maxX + i), qMinX, _CMP_GE_OQ));
+        hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(batch->minY + i), qMaxY, _CMP_LE_OQ),
+            _mm256_cmp_ps(_mm256_loadu_ps(batch->maxY + i), qMinY, _CMP_GE_OQ)));
+        mask |= (uint32_t) _mm256_movemask_ps(hit) << i;
+    }
+#elif COLLISION_BATCH_LANES == 4
+    const __m128 qMinX = _mm_set1_ps(minX), qMinY = _mm_set1_ps(minY);
+    const __m128 qMaxX = _mm_set1_ps(maxX), qMaxY = _mm_set1_ps(maxY);
+    __m128 hit;
+    for (i = 0; i < batch->count; i += 4) {
+        hit = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(batch->minX + i), qMaxX),
+            _mm_cmpge_ps(_mm_loadu_ps(batch->maxX + i), qMinX));
+        hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(batch->minY + i), qMaxY),
+            _mm_cmpge_ps(_mm_loadu_ps(batch->maxY + i), qMinY)));
+        mask |= (uint32_t) _mm_movemask_ps(hit) << i;
+    }
+#else
+    for (i = 0; i < batch->count; i++) {
+        mask |= (uint32_t) (batch->minX[i] <= maxX && batch->maxX[i] >= minX &&
+            batch->minY[i] <= maxY && batch->maxY[i] >= minY) << i;
+    }
+#endif
+
+    return mask & collision_batch_live_mask(batch->count);
+}
+
+uint32_t collision_batch_inside_circle(const collision_batch_t *batch, const float centerX, const float centerY,
+    const float radiusSq) {
+    uint32_t i, mask = 0;
+    if (!batch) {
+        return 0;
+    }
+
+#if COLLISION_BATCH_LANES == 8
+    const __m256 cx = _mm256_set1_ps(centerX), cy = _mm256_set1_ps(centerY), r2 = _mm256_set1_ps(radiusSq);
+    __m256 dx, dy;
+    for (i = 0; i < batch->count; i += 8) {
+        dx = _mm256_sub_ps(_mm256_loadu_ps(batch->posX + i), cx);
+        dy = _mm256_sub_ps(_mm256_loadu_ps(batch->posY + i), cy);
+        dx = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        mask |= (uint32_t) _mm256_movemask_ps(_mm256_cmp_ps(dx, r2, _CMP_LE_OQ)) << i;
+    }
+#elif COLLISION_BATCH_LANES == 4
+    const __m128 cx = _mm_set1_ps(centerX), cy = _mm_set1_ps(centerY), r2 = _mm_set1_ps(radiusSq);
+    __m128 dx, dy;
+    for (i = 0; i < batch->count; i += 4) {
+        dx = _mm_sub_ps(_mm_loadu_ps(batch->posX + i), cx);
+        dy = _mm_sub_ps(_mm_loadu_ps(batch->posY + i), cy);
+        dx = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        mask |= (uint32_t) _mm_movemask_ps(_mm_cmple_ps(dx, r2)) << i;
+    }
+#else
+    float dx, dy;
+    for (i = 0; i < batch->count; i++) {
+        dx = batch->posX[i] - centerX;
+        dy = batch->posY[i] - centerY;
+        mask |= (uint32_t) (dx * dx + dy * dy <= radiusSq) << i;
+    }
+#endif
+
+    return mask & collision_batch_live_mask(batch->count);
+}
+
+const char *collision_batch_kernel_name(void) {
+#if COLLISION_BATCH_LANES == 8
+    return "avx";
+#elif COLLISION_BATCH_LANES == 4
+    return "sse";
+#else
+    return "scalar";
+#endif
+}
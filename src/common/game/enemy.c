@@ -1,5 +1,6 @@
 #include "common/def.h"
 #include "common/logger.h"
+#include "common/buffer/arena.h"
 #include "common/game/collision.h"
 #include "common/game/game.h"
 #include "common/game/tower.h"
@@ -17,6 +18,8 @@
 #include "common/render/gf2d_sprite.h"
 
 #include "server/server.h"
+#include "server/game/match.h"
+#include "server/game/player_manager.h"
 
 extern uint8_t __DEBUG_LINES;
 
@@ -25,6 +28,9 @@ extern uint8_t __DEBUG_LINES;
 #define ENEMY_PATH_RETRY_INTERVAL 0.15f
 #define ENEMY_PATH_GOAL_SEARCH_RADIUS 8
 #define ENEMY_PATH_WAYPOINT_EPSILON 4.0f
+#define ENEMY_LOD_REDUCED_INTERVAL 4 // Ticks between updates of an enemy in transit
+#define ENEMY_LOD_HOLD_TIME 0.5f // Time a promoted enemy stays at full rate after it was last near something
+#define ENEMY_LOD_PLAYER_DISTANCE (TILE_SIZE * 12.0f)
 
 struct enemy_def_manager_s {
     enemy_def_t *enemyDefs;
@@ -32,22 +38,16 @@ struct enemy_def_manager_s {
     int numEnemyDefs;
 };
 
+static uint32_t enemy_terrain_plane(const enemy_state_t *state) {
+    return state->def->type == ENEMY_TYPE_AIR ? OCCUPANCY_NO_FLY : OCCUPANCY_NO_WALK;
+}
+
 static uint8_t enemy_tile_allows_movement(const enemy_state_t *state, const GFC_Vector2D worldPos) {
-    tile_t *tile;
     if (!state || !state->def || !g_game.world) {
         return 0;
     }
 
-    tile = world_get_tile_at_position(g_game.world, worldPos, NULL);
-    if (!tile) {
-        return 0;
-    }
-
-    if (state->def->type == ENEMY_TYPE_AIR) {
-        return tile->properties.flyable;
-    }
-
-    return tile->properties.walkable;
+    return !world_area_blocked(g_game.world, gfc_rect(worldPos.x, worldPos.y, 0, 0), enemy_terrain_plane(state));
 }
 
 static void enemy_clear_path(enemy_state_t *state) {
@@ -113,11 +113,9 @@ static int enemy_can_occupy_tile(const enemy_state_t *state, entity_t *ent, cons
         return 0;
     }
 
-    if (collision_check_world(g_game.world, ent, worldPos)) {
-        return 0;
-    }
-
-    return 1;
+    // Only static blockers matter for paths, the occupancy map answers without touching entities
+    return !world_area_blocked(g_game.world, gfc_rect(worldPos.x + ent->boundingBox.x, worldPos.y + ent->boundingBox.y,
+        ent->boundingBox.w, ent->boundingBox.h), OCCUPANCY_SOLID);
 }
 
 static int enemy_find_goal_tile(enemy_state_t *state, entity_t *ent, const GFC_Vector2I startTile,
@@ -345,8 +343,8 @@ cleanup:
 
 static float enemy_tile_speed_multiplier(const GFC_Vector2D worldPos) {
     tile_t *tile;
-    if (!g_game.world) {
-        return 1.0f;
+    if (!g_game.world || !world_test_tile_flag(g_game.world, worldPos, TILE_FLAG_MODIFY_SPEED)) {
+        return 1.0f; // Most tiles, answered by the flag planes without a tile lookup
     }
 
     tile = world_get_tile_at_position(g_game.world, worldPos, NULL);
@@ -370,7 +368,7 @@ static GFC_Vector2D enemy_get_target_position(const enemy_state_t *state) {
 static void enemy_apply_tile_effects(enemy_state_t *state, const GFC_Vector2D worldPos, const float deltaTime) {
     tile_t *tile;
     const float minDeltaTime = fmaxf(0.0f, deltaTime);
-    if (!state || !g_game.world) {
+    if (!state || !g_game.world || !world_test_tile_flag(g_game.world, worldPos, TILE_FLAG_HARMFUL)) {
         return;
     }
 
@@ -536,34 +534,40 @@ entity_t * enemy_spawn(const struct entity_manager_s *entityManager, const enemy
     entity_t *ent;
 
     ent = entity_new(entityManager, entity_next_id((entity_manager_t *)entityManager));
+    if (!ent) {
+        return NULL;
+    }
+
+    enemy_state_t *state = entity_new_state(entityManager, ent, ENTITY_TYPE_ENEMY);
+    if (!state) {
+        entity_free(entityManager, ent);
+        return NULL;
+    }
+
     ent->position = pos;
 
     ent->layers = ENT_LAYER_ENEMY;
     ent->boundingBox = def->modelDef.boundingBox;
+    entity_sync_hot(entityManager, ent);
 
     world_add_entity(g_game.world, ent);
-    enemy_state_t *state = gfc_allocate_array(sizeof(enemy_state_t), 1);
     state->def = def;
     state->health = def->maxHealth;
     state->pathRecalcTimer = 0.0f;
     state->hasPathGoal = 0;
     state->targetTeamID = TEAM_NONE;
 
+    // Only the server moves enemies, clients place them from snapshots
+    if (g_game.role == GAME_ROLE_SERVER && g_game.world &&
+        !phys_add_body(&g_game.world->bodies, ent, ENT_LAYER_ENEMY, OCCUPANCY_SOLID, enemy_terrain_plane(state))) {
+        log_error("Failed to give enemy %lld a physics body", (long long) ent->id);
+    }
+
     if (g_game.role == GAME_ROLE_CLIENT) {
         state->bodySprite = gf2d_sprite_load_image(def->modelDef.bodySpritePath);
         state->handsSprite = gf2d_sprite_load_image(def->modelDef.handsSpritePath);\
     }
 
-    state->targets = gfc_list_new();
-
-    ent->data = state;
-
-    ent->think = enemy_think;
-    ent->update = enemy_update;
-    ent->draw = enemy_draw;
-    ent->destroy = enemy_destroy;
-    ent->collidesWith = enemy_collides_with;
-
     return ent;
 }
 
@@ -629,25 +633,17 @@ enemy_size_t enemy_size_from_string(const char *str) {
     return ENEMY_SIZE_SMALL; // Default to small if invalid
 }
 
-GFC_Vector2D enemy_move(entity_t *ent, float deltaTime) {
-    GFC_Vector2D direction, moveDelta, newPosition;
+static void enemy_plan_path(entity_t *ent, enemy_state_t *state, const float deltaTime) {
     GFC_Vector2I startTile, desiredGoalTile, pathGoalTile;
     int needRepath = 0;
-    float speed;
-    if (!ent || !ent->data) {
-        return ent ? ent->position : gfc_vector2d(0, 0);
-    }
 
-    enemy_state_t *state = (enemy_state_t *)ent->data;
-    world_t *world = g_game.world;
-    speed = state->def->speed * enemy_tile_speed_multiplier(ent->position);
     state->pathRecalcTimer -= deltaTime;
 
     startTile = enemy_world_to_tile(ent->position);
     desiredGoalTile = enemy_world_to_tile(enemy_get_target_position(state));
 
-    if (!enemy_tile_in_bounds(world, startTile)) {
-        return ent->position;
+    if (!enemy_tile_in_bounds(g_game.world, startTile)) {
+        return;
     }
 
     if (!state->pathTiles || state->pathIndex >= state->pathLength) {
@@ -668,10 +664,23 @@ GFC_Vector2D enemy_move(entity_t *ent, float deltaTime) {
             enemy_clear_path(state);
             state->pathRecalcTimer = ENEMY_PATH_RETRY_INTERVAL;
             state->hasPathGoal = 0;
-            return ent->position;
         }
     }
+}
+
+// Where the enemy wants to go this tick, blockers are left to phys_step
+GFC_Vector2D enemy_move(entity_t *ent, float deltaTime) {
+    GFC_Vector2D direction, moveDelta, newPosition;
+    float speed;
+    if (!ent || !ent->data) {
+        return ent ? ent->position : gfc_vector2d(0, 0);
+    }
+
+    enemy_state_t *state = (enemy_state_t *)ent->data;
+    world_t *world = g_game.world;
+    speed = state->def->speed * enemy_tile_speed_multiplier(ent->position);
 
+    // Paths are planned in enemy_think, which may run on a worker thread
     if (!state->pathTiles || state->pathIndex >= state->pathLength) {
         return ent->position;
     }
@@ -724,34 +733,118 @@ GFC_Vector2D enemy_move(entity_t *ent, float deltaTime) {
         );
     }
 
-    if (collision_check_world(world, ent, newPosition) || !enemy_tile_allows_movement(state, newPosition)) {
-        state->pathRecalcTimer = 0.0f;
-        return ent->position;
+    return newPosition;
+}
+
+static float enemy_lod_step(const entity_t *ent, enemy_state_t *state) {
+    if (g_game.role != GAME_ROLE_SERVER) {
+        return g_game.deltaTime;
     }
 
-    world_move_entity(world, ent, newPosition);
-    return newPosition;
+    // Reduced enemies are staggered by ID so their ticks spread evenly
+    state->lodElapsed += g_game.deltaTime;
+    if (state->lodLevel == ENEMY_LOD_REDUCED && (g_game.tickNumber + (uint64_t) ent->id) % ENEMY_LOD_REDUCED_INTERVAL != 0) {
+        state->lodStep = 0.0f;
+        return 0.0f;
+    }
+
+    state->lodStep = state->lodElapsed;
+    state->lodElapsed = 0.0f;
+    return state->lodStep;
+}
+
+static uint8_t enemy_lod_near_player(const entity_t *ent) {
+    const player_t **players;
+    size_t i, playerCount;
+    if (!g_match) {
+        return 0;
+    }
+
+    players = player_manager_get_all(g_match->playerManager, &playerCount);
+    for (i = 0; i < playerCount; i++) {
+        if (players[i] && players[i]->entity &&
+            gfc_vector2d_magnitude_between_squared(ent->position, players[i]->entity->position) < ENEMY_LOD_PLAYER_DISTANCE * ENEMY_LOD_PLAYER_DISTANCE) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void enemy_lod_classify(const entity_t *ent, enemy_state_t *state, const float step) {
+    if (state->numTargets > 0 || enemy_lod_near_player(ent)) {
+        state->lodLevel = ENEMY_LOD_FULL;
+        state->lodHoldTimer = ENEMY_LOD_HOLD_TIME;
+        return;
+    }
+
+    state->lodHoldTimer -= step;
+    if (state->lodHoldTimer <= 0.0f) {
+        state->lodLevel = ENEMY_LOD_REDUCED;
+    }
+}
+
+void enemy_lod_promote(const entity_manager_t *entityManager, entity_t *ent, const void *payload) {
+    enemy_state_t *state;
+    float hold = ENEMY_LOD_HOLD_TIME;
+    if (!ent || !ent->data) {
+        return;
+    }
+
+    if (payload) {
+        hold = fmaxf(hold, *(const float *)payload);
+    }
+
+    state = (enemy_state_t *)ent->data;
+    state->lodLevel = ENEMY_LOD_FULL;
+    state->lodHoldTimer = fmaxf(state->lodHoldTimer, hold);
+}
+
+typedef struct enemy_target_search_s {
+    const entity_manager_t *entityManager;
+    enemy_state_t *state;
+} enemy_target_search_t;
+
+static int enemy_visit_target(entity_t *target, void *userData) {
+    enemy_target_search_t *search = (enemy_target_search_t *)userData;
+    enemy_state_t *state = search->state;
+
+    if (state->targetTeamID >= TEAM_ONE && state->targetTeamID <= TEAM_TWO) {
+        tower_state_t *towerState = (tower_state_t *)target->data;
+        if (!towerState || towerState->teamID != state->targetTeamID) {
+            return 1;
+        }
+    }
+    state->targets[state->numTargets++] = entity_get_handle(search->entityManager, target);
+    return state->numTargets < ENEMY_MAX_TARGETS;
 }
 
 void enemy_think(const entity_manager_t *entityManager, entity_t *ent) {
     GFC_Vector2D direction, rayCastEnd;
+    collision_filter_t filter = { .layerMask = ENT_LAYER_TOWER, .solidOnly = 1 };
+    enemy_target_search_t search;
     if (!ent || !ent->data) {
         return;
     }
 
     enemy_state_t *state = (enemy_state_t *)ent->data;
-    state->attackCooldownTimer -= g_game.deltaTime;
+    const float step = enemy_lod_step(ent, state);
+    if (state->health <= 0 && g_game.role == GAME_ROLE_SERVER) {
+        entity_queue_destroy(entityManager, ent);
+        return;
+    }
+    if (step <= 0.0f) {
+        return; // Skipped by the LOD scheduler
+    }
+
+    state->attackCooldownTimer -= step;
 
     if (g_game.role != GAME_ROLE_SERVER) {
         return; // Only run AI logic on the server
     }
 
-    if (state->health <= 0) {
-        ent->think = entity_free; // Mark for deletion
-        return;
-    }
+    state->attackTargetTimer -= step;
 
-    state->attackTargetTimer -= g_game.deltaTime;
+    enemy_plan_path(ent, state, step);
 
     gfc_vector2d_sub(direction, enemy_get_target_position(state), ent->position);
     gfc_vector2d_normalize(&direction);
@@ -761,34 +854,18 @@ void enemy_think(const entity_manager_t *entityManager, entity_t *ent) {
         gfc_vector2d_scale(direction, direction, state->def->range);
         gfc_vector2d_add(rayCastEnd, ent->position, direction);
 
-        gfc_list_clear(state->targets);
-
-        collision_raycast_world(g_game.world, ent, ent->position, rayCastEnd, state->targets);
-
-        for (size_t i = 0; i < gfc_list_count(state->targets); i++) {
-            entity_t *target = gfc_list_get_nth(state->targets, i);
-            if (!(target->layers & ENT_LAYER_TOWER)) {
-                gfc_list_delete_nth(state->targets, i);
-                i--; // Adjust index after removal
-                continue;
-            }
-            if (state->targetTeamID >= TEAM_ONE && state->targetTeamID <= TEAM_TWO) {
-                tower_state_t *towerState = (tower_state_t *)target->data;
-                if (!towerState || towerState->teamID != state->targetTeamID) {
-                    gfc_list_delete_nth(state->targets, i);
-                    i--;
-                    continue;
-                }
-            }
-        }
+        state->numTargets = 0;
+        filter.source = ent;
+        search.entityManager = entityManager;
+        search.state = state;
+        collision_visit_segment(g_game.world, ent->position, rayCastEnd, &filter, enemy_visit_target, &search);
 
         state->attackTargetTimer = g_game.deltaTime * 5; // every 5 ticks
     }
 }
 
 void enemy_update(const entity_manager_t *entityManager, entity_t *ent, float deltaTime) {
-    GFC_Vector2D newPosition, diff;
-    uint32_t i;
+    uint32_t i, bodyFlags;
     if (!ent || !ent->data) {
         return;
     }
@@ -798,33 +875,42 @@ void enemy_update(const entity_manager_t *entityManager, entity_t *ent, float de
     }
 
     enemy_state_t *state = (enemy_state_t *)ent->data;
+    if (state->lodStep <= 0.0f) {
+        return; // Skipped by the LOD scheduler
+    }
+    deltaTime = state->lodStep;
 
-    newPosition = enemy_move(ent, deltaTime);
-    gfc_vector2d_sub(diff, ent->position, newPosition);
-    if (newPosition.x != ent->position.x || newPosition.y != ent->position.y) {
+    // Moved by the phys_step in enemy_update_batch
+    bodyFlags = phys_body_flags(&g_game.world->bodies, ent);
+    if (bodyFlags & PHYS_BODY_MOVED) {
         state->dirtyFlags |= ENEMY_DIRTY_POSITION;
     }
-    ent->position = newPosition;
+    if (bodyFlags & PHYS_BODY_BLOCKED) {
+        state->pathRecalcTimer = 0.0f;
+    }
     enemy_apply_tile_effects(state, ent->position, deltaTime);
 
-    if (state->attackCooldownTimer <= 0 && gfc_list_count(state->targets) > 0) {
+    if (state->attackCooldownTimer <= 0 && state->numTargets > 0) {
 
-        for (i = 0; i < gfc_list_count(state->targets); i++) {
-            entity_t *target = gfc_list_get_nth(state->targets, i);
-            if (!target || !target->_inUse || !target->data) {
-                continue;
+        for (i = 0; i < state->numTargets; i++) {
+            entity_t *target = entity_resolve(entityManager, state->targets[i]);
+            if (!target || !target->data) {
+                continue; // Destroyed since the last target scan
             }
             tower_state_t *towerState = (tower_state_t *)target->data;
             towerState->health -= state->def->damage;
             towerState->dirtyFlags |= TOWER_DIRTY_HEALTH;
+            entity_wake(entityManager, target); // Has a snapshot to send and may need destroying
         }
 
         state->attackCooldownTimer = state->def->attackCooldown;
         state->dirtyFlags |= ENEMY_DIRTY_ATTACK;
     }
 
+    enemy_lod_classify(ent, state, deltaTime);
+
     if (state->dirtyFlags) {
-        s2c_enemy_snapshot_packet_t *pkt = gfc_allocate_array(sizeof(s2c_enemy_snapshot_packet_t), 1);
+        s2c_enemy_snapshot_packet_t *pkt = buf_tick_alloc(sizeof(s2c_enemy_snapshot_packet_t));
         enemy_snapshot_data_t eventData = {0};
         eventData.updateData.xPos = ent->position.x;
         eventData.updateData.yPos = ent->position.y;
@@ -839,6 +925,35 @@ void enemy_update(const entity_manager_t *entityManager, entity_t *ent, float de
     state->dirtyFlags = 0;
 }
 
+void enemy_think_batch(const entity_manager_t *entityManager, entity_t **ents, const uint32_t count) {
+    uint32_t i;
+    for (i = 0; i < count; i++) {
+        if (entity_batch_skip(ents[i])) continue;
+        enemy_think(entityManager, ents[i]);
+    }
+}
+
+void enemy_update_batch(const entity_manager_t *entityManager, entity_t **ents, const uint32_t count, const float deltaTime) {
+    enemy_state_t *state;
+    uint32_t i;
+
+    // Every move is submitted first and resolved in one physics pass, crowds push apart without probing the world per enemy
+    if (g_game.role == GAME_ROLE_SERVER && g_game.world) {
+        for (i = 0; i < count; i++) {
+            if (entity_batch_skip(ents[i]) || !ents[i]->data) continue;
+            state = (enemy_state_t *)ents[i]->data;
+            if (state->lodStep <= 0.0f) continue;
+            phys_move_body(&g_game.world->bodies, ents[i], enemy_move(ents[i], state->lodStep));
+        }
+        phys_step(&g_game.world->bodies, g_game.world, entityManager);
+    }
+
+    for (i = 0; i < count; i++) {
+        if (entity_batch_skip(ents[i])) continue;
+        enemy_update(entityManager, ents[i], deltaTime);
+    }
+}
+
 void enemy_draw(const entity_manager_t *entityManager, entity_t *ent) {
     GFC_Vector2D position, centerPos, heldItemOffset, itemCenterPos;
     Sprite *headSprite, *handsSprite;
@@ -881,18 +996,34 @@ void enemy_destroy(const entity_manager_t *entityManager, entity_t *ent) {
 
     enemy_state_t *state = (enemy_state_t *)ent->data;
 
-    gfc_list_delete(state->targets);
     enemy_clear_path(state);
     gf2d_sprite_free(state->bodySprite);
     gf2d_sprite_free(state->handsSprite);
 
+    if (g_game.world) {
+        phys_remove_body(&g_game.world->bodies, ent);
+    }
     world_remove_entity(g_game.world, ent);
+}
 
-    if (g_game.role == GAME_ROLE_SERVER) {
-        s2c_enemy_snapshot_packet_t *pkt = gfc_allocate_array(sizeof(s2c_enemy_snapshot_packet_t), 1);
-        enemy_snapshot_data_t eventData;
-        create_s2c_enemy_snapshot(pkt, ent->id, ENEMY_EVENT_DESPAWN, &eventData);
-        server_broadcast_packet_batch(&g_server, pkt);
+void enemy_despawn_batch(const entity_manager_t *entityManager, entity_t **ents, const uint32_t count) {
+    s2c_enemy_despawn_batch_packet_t *pkt;
+    int64_t enemyIDs[ENEMY_DESPAWN_BATCH_MAX];
+    uint32_t i, numIDs = 0;
+
+    if (g_game.role != GAME_ROLE_SERVER) {
+        return;
+    }
+
+    // One packet per ENEMY_DESPAWN_BATCH_MAX enemies instead of one per enemy
+    for (i = 0; i < count; i++) {
+        enemyIDs[numIDs++] = ents[i]->id;
+        if (numIDs == ENEMY_DESPAWN_BATCH_MAX || i + 1 == count) {
+            pkt = buf_tick_alloc(sizeof(s2c_enemy_despawn_batch_packet_t));
+            create_s2c_enemy_despawn_batch(pkt, enemyIDs, (uint16_t) numIDs);
+            server_broadcast_packet_batch(&g_server, pkt);
+            numIDs = 0;
+        }
     }
 }
 
@@ -902,12 +1033,22 @@ uint32_t enemy_collides_with(entity_t *ent, entity_t *other) {
     }
 
     if (other->layers & ENT_LAYER_TOWER) {
-        tower_state_t *towerState = (tower_state_t *)other->data;
-        if (strcmp(towerState->def->name, "Slow Trap") == 0) {
-            return COLLISION_NONE;
-        }
-        return COLLISION_SOLID;
+        return (other->flags & ENT_FLAG_COLLIDE_SOLID) ? COLLISION_SOLID : COLLISION_NONE; // Set at spawn, see tower_place
     }
 
     return COLLISION_NONE;
-}
\ No newline at end of file
+}
+
+void enemy_register_entity_type(void) {
+    static const entity_type_ops_t ops = {
+        .thinkBatch = enemy_think_batch,
+        .updateBatch = enemy_update_batch,
+        .draw = enemy_draw,
+        .destroy = enemy_destroy,
+        .despawnBatch = enemy_despawn_batch,
+        .collidesWith = enemy_collides_with,
+        .stateSize = sizeof(enemy_state_t),
+        .statePoolSize = ENEMY_STATE_POOL_SIZE
+    };
+    entity_register_type(ENTITY_TYPE_ENEMY, &ops);
+}
@@ -7,91 +7,446 @@
 #include "common/render/gf2d_draw.h"
 #include "common/logger.h"
 #include "common/game/game.h"
+#include "common/game/world/world.h"
+#include "common/buffer/arena.h"
+#include "common/timer_wheel.h"
+#include "common/thread/atomic.h"
+#include "common/thread/worker_pool.h"
+
+#define ENTITY_PARALLEL_MIN_ENTITIES 64 // Below this, dispatch overhead outweighs the gain
+#define ENTITY_PARALLEL_BLOCK_SIZE 16
+#define ENTITY_REORDER_WINDOW 256 // Hot rows sorted per entity_reorder_spatial call
+#define ENTITY_REORDER_BIAS 0x8000 // Moves negative chunk coordinates into the unsigned key range
+#define ENTITY_REORDER_FREE_KEY UINT32_MAX // Sorts free rows behind the live ones
 
 extern uint8_t __DEBUG_LINES;
 
+typedef struct entity_cmd_s {
+    uint32_t order; // Position in the think list, commands are committed in this order
+    entity_handle_t handle;
+    entity_deferred_fn fn;
+    uint64_t payload[ENTITY_DEFERRED_PAYLOAD_SIZE / sizeof(uint64_t)];
+} entity_cmd_t;
+
+typedef struct entity_cmd_buffer_s {
+    entity_cmd_t *cmds;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t head;
+} entity_cmd_buffer_t;
+
+typedef struct entity_think_job_s {
+    entity_manager_t *manager;
+    const game_t *game;
+    uint32_t count;
+    const uint32_t *typeStart; // Start of each type's run in the pass list
+    atomic_u32_t nextIndex;
+} entity_think_job_t;
+
+typedef struct entity_reorder_key_s {
+    uint32_t key;
+    uint32_t row;
+} entity_reorder_key_t;
+
+typedef struct entity_id_entry_s {
+    int64_t id;
+    uint32_t slot;
+} entity_id_entry_t;
+
 struct entity_manager_s {
-    entity_t *ents;
-    uint64_t *idToSlot;
-    uint32_t maxEnts;
-    int64_t maxIdSlots;
-    int64_t nextId;
+    entity_t **chunks; // ENTITY_CHUNK_SIZE slots each, the last one may be shorter when the limit is not a multiple
+    uint32_t numChunks;
+    uint32_t capacity; // Slots across all chunks, every per slot array below holds this many
+    uint32_t maxEnts; // Hard limit on capacity
+    uint32_t numEnts;
+    uint16_t *generations; // Current generation of each slot, never 0 so a zero handle is always invalid
+
+    uint32_t highWater;
+    uint32_t allocFailures;
+
+    // Sparse set from network ID to slot, keyed by the handle index bits of the ID
+    uint32_t *idSparse; // Position in idDense for each key, grown on demand up to ENTITY_HANDLE_MAX_SLOTS
+    uint32_t idSparseSize;
+    entity_id_entry_t *idDense; // Live mappings, at most one per slot
+    uint32_t numIds;
+
+    entity_hot_t hot;
+    uint32_t *rowSlots; // Slot stored in each hot row, inverse of hot.rows
+    uint32_t reorderCursor; // First hot row of the next reorder window
+
+    uint32_t *freeSlots; // Stack of free slot indices, popped by entity_new
+    uint32_t numFreeSlots;
+    uint32_t *activeList; // Packed slot indices of live entities, swap-removed on free. Awake ones come first
+    uint32_t *activeIndex; // Position of each slot in activeList
+    uint32_t numAwake; // Length of the awake prefix of activeList, the only part the passes walk
+
+    // Pass and flush lists are only resized between passes, batch callbacks hold pointers into them
+    entity_t **passList; // Snapshot of activeList for the current pass, entities may spawn or free mid pass
+    uint32_t passCapacity;
+    entity_handle_t *destroyQueue; // Entities queued by entity_queue_destroy, at most one entry per slot
+    uint32_t numDestroyQueued;
+    entity_t **flushList; // Entities being destroyed by the current flush, grouped by type
+    uint32_t flushCapacity;
+    entity_cmd_buffer_t *cmdBuffers;
+    uint32_t numCmdBuffers;
+    entity_splash_t *splashes; // Heap owned so queued impacts survive tick arena resets, see entity_queue_splash
+    uint32_t numSplashes;
+    uint32_t splashCapacity;
+
+    buf_pool_t statePools[ENTITY_TYPE_COUNT]; // Zeroed for types without a state pool
+
+    // Sleeping entities have a wake timer keyed by slot, the wheel advances once per think pass
+    timer_wheel_t wakeTimers;
+    uint64_t *sleepStart; // Wheel tick each sleeping slot went to sleep on
 };
 
-entity_manager_t *entity_init(const uint32_t maxEnts) {
-    entity_manager_t *manager = malloc(sizeof(entity_manager_t));
+static const entity_type_ops_t entity_no_ops = {0};
+
+static const entity_type_ops_t entity_static_ops = {
+    .draw = entity_draw
+};
+
+static const entity_type_ops_t entity_animated_ops = {
+    .updateBatch = entity_update_animated_batch,
+    .draw = entity_draw_animated
+};
+
+// Registered once at startup, read only afterwards
+static const entity_type_ops_t *entity_types[ENTITY_TYPE_COUNT] = {
+    [ENTITY_TYPE_STATIC] = &entity_static_ops,
+    [ENTITY_TYPE_ANIMATED] = &entity_animated_ops
+};
+
+#define entity_ops(type) (entity_types[type] ? entity_types[type] : &entity_no_ops)
+
+// ENTITY_CHUNK_SIZE is a power of two, the divide and modulo compile to a shift and a mask
+#define entity_at(manager, slot) (&(manager)->chunks[(slot) / ENTITY_CHUNK_SIZE][(slot) % ENTITY_CHUNK_SIZE])
+#define entity_owned(manager, ent) ((ent)->_slot < (manager)->capacity && entity_at(manager, (ent)->_slot) == (ent))
+
+// Set while a worker runs the parallel think phase, NULL otherwise
+static __thread entity_cmd_buffer_t *t_cmdBuffer = NULL;
+static __thread uint32_t t_cmdOrder = 0;
+
+static int entity_grow_array(void **array, const size_t size, const uint32_t oldCount, const uint32_t newCount) {
+    void *newArray = realloc(*array, size * newCount);
+    if (!newArray) return 0;
+
+    memset((uint8_t *) newArray + size * oldCount, 0, size * (newCount - oldCount));
+    *array = newArray;
+    return 1;
+}
+
+static int entity_hot_grow(entity_hot_t *hot, const uint32_t oldCount, const uint32_t newCount) {
+    return entity_grow_array((void **) &hot->rows, sizeof(uint32_t), oldCount, newCount) &&
+        entity_grow_array((void **) &hot->posX, sizeof(float), oldCount, newCount) &&
+        entity_grow_array((void **) &hot->posY, sizeof(float), oldCount, newCount) &&
+        entity_grow_array((void **) &hot->minX, sizeof(float), oldCount, newCount) &&
+        entity_grow_array((void **) &hot->minY, sizeof(float), oldCount, newCount) &&
+        entity_grow_array((void **) &hot->maxX, sizeof(float), oldCount, newCount) &&
+        entity_grow_array((void **) &hot->maxY, sizeof(float), oldCount, newCount) &&
+        entity_grow_array((void **) &hot->layers, sizeof(uint16_t), oldCount, newCount);
+}
+
+static void entity_hot_close(entity_hot_t *hot) {
+    free(hot->rows);
+    free(hot->posX);
+    free(hot->posY);
+    free(hot->minX);
+    free(hot->minY);
+    free(hot->maxX);
+    free(hot->maxY);
+    free(hot->layers);
+    memset(hot, 0, sizeof(entity_hot_t));
+}
+
+// Adds one chunk of slots, existing entities stay where they are
+static int entity_grow(entity_manager_t *manager) {
+    entity_t *chunk, **newChunks;
+    uint32_t i, oldCapacity = manager->capacity, newCapacity;
+    if (oldCapacity >= manager->maxEnts) return 0;
+
+    newCapacity = oldCapacity + ENTITY_CHUNK_SIZE;
+    if (newCapacity > manager->maxEnts) newCapacity = manager->maxEnts;
+
+    newChunks = realloc(manager->chunks, sizeof(entity_t *) * (manager->numChunks + 1));
+    if (!newChunks) {
+        log_error("Failed to grow entity chunk table");
+        return 0;
+    }
+    manager->chunks = newChunks;
+
+    chunk = gfc_allocate_array(sizeof(entity_t), newCapacity - oldCapacity);
+    if (!chunk) {
+        log_error("Failed to allocate entity chunk");
+        return 0;
+    }
+
+    // Arrays that grew before a failure keep their new size, capacity only moves once all of them fit
+    if (!entity_grow_array((void **) &manager->generations, sizeof(uint16_t), oldCapacity, newCapacity) ||
+        !entity_grow_array((void **) &manager->idDense, sizeof(entity_id_entry_t), oldCapacity, newCapacity) ||
+        !entity_grow_array((void **) &manager->freeSlots, sizeof(uint32_t), oldCapacity, newCapacity) ||
+        !entity_grow_array((void **) &manager->activeList, sizeof(uint32_t), oldCapacity, newCapacity) ||
+        !entity_grow_array((void **) &manager->activeIndex, sizeof(uint32_t), oldCapacity, newCapacity) ||
+        !entity_grow_array((void **) &manager->destroyQueue, sizeof(entity_handle_t), oldCapacity, newCapacity) ||
+        !entity_grow_array((void **) &manager->rowSlots, sizeof(uint32_t), oldCapacity, newCapacity) ||
+        !entity_grow_array((void **) &manager->sleepStart, sizeof(uint64_t), oldCapacity, newCapacity) ||
+        !timer_wheel_reserve(&manager->wakeTimers, newCapacity) ||
+        !entity_hot_grow(&manager->hot, oldCapacity, newCapacity)) {
+        free(chunk);
+        log_error("Failed to grow entity slot arrays");
+        return 0;
+    }
+
+    manager->chunks[manager->numChunks++] = chunk;
+    for (i = oldCapacity; i < newCapacity; i++) {
+        chunk[i - oldCapacity]._slot = i;
+        manager->generations[i] = 1;
+        manager->hot.rows[i] = i; // New rows start in slot order, entity_reorder_spatial moves them later
+        manager->rowSlots[i] = i;
+    }
+
+    // Pushed highest first so the lowest slots are handed out first
+    for (i = newCapacity; i > oldCapacity; i--) {
+        manager->freeSlots[manager->numFreeSlots++] = i - 1;
+    }
+    manager->capacity = newCapacity;
+    return 1;
+}
+
+static int entity_reserve_list(entity_t ***list, uint32_t *listCapacity, const uint32_t count) {
+    if (count <= *listCapacity) return 1;
+    if (!entity_grow_array((void **) list, sizeof(entity_t *), *listCapacity, count)) {
+        log_error("Failed to grow entity pass list");
+        return 0;
+    }
+    *listCapacity = count;
+    return 1;
+}
+
+entity_manager_t *entity_init(uint32_t initialEnts, uint32_t maxEnts) {
+    const entity_type_ops_t *ops;
+    uint32_t type;
+    entity_manager_t *manager = calloc(1, sizeof(entity_manager_t));
     if (!manager) {
         log_error("Failed to allocate memory for entity manager");
         return NULL;
     }
-
-    manager->ents = gfc_allocate_array(sizeof(entity_t), maxEnts);
-    if (!manager->ents) {
+    if (!timer_wheel_init(&manager->wakeTimers, 0)) {
         free(manager);
-        log_error("Failed to allocate memory for entities");
+        log_error("Failed to initialize entity wake timers");
         return NULL;
     }
 
-    manager->idToSlot = calloc(maxEnts, sizeof(uint64_t));
-    if (!manager->idToSlot) {
-        free(manager->ents);
-        free(manager);
-        log_error("Failed to allocate memory for ID to slot mapping");
-        return NULL;
+    if (maxEnts == 0) maxEnts = ENTITY_DEFAULT_LIMIT;
+    if (maxEnts > ENTITY_HANDLE_MAX_SLOTS) {
+        log_warn("Entity limit of %u exceeds the handle limit, clamping to %u", maxEnts, ENTITY_HANDLE_MAX_SLOTS);
+        maxEnts = ENTITY_HANDLE_MAX_SLOTS;
     }
+    if (initialEnts == 0) initialEnts = ENTITY_CHUNK_SIZE;
+    if (initialEnts > maxEnts) initialEnts = maxEnts;
 
     manager->maxEnts = maxEnts;
-    manager->maxIdSlots = maxEnts;
-    manager->nextId = 1; // Start IDs from 1 to avoid using
+    while (manager->capacity < initialEnts) {
+        if (!entity_grow(manager)) {
+            entity_close(manager);
+            free(manager);
+            log_error("Failed to allocate memory for %u entities", initialEnts);
+            return NULL;
+        }
+    }
+
+    // Types register before the first manager is created, their state blocks are allocated here and reused all match
+    for (type = 0; type < ENTITY_TYPE_COUNT; type++) {
+        ops = entity_ops(type);
+        if (!ops->stateSize || !ops->statePoolSize) continue;
+        if (!buf_pool_init(&manager->statePools[type], ops->statePoolSize, ops->stateSize)) {
+            log_warn("Failed to pre-allocate %u states for entity type %u, falling back to the heap", ops->statePoolSize, type);
+        }
+    }
+
     return manager;
 }
 
 void entity_close(const entity_manager_t *manager) {
-    if (manager->ents) free(manager->ents);
+    uint32_t i;
+    if (manager->chunks) {
+        for (i = 0; i < manager->numChunks; i++) {
+            free(manager->chunks[i]);
+        }
+        free(manager->chunks);
+    }
+    if (manager->generations) free(manager->generations);
+    if (manager->idSparse) free(manager->idSparse);
+    if (manager->idDense) free(manager->idDense);
+    if (manager->freeSlots) free(manager->freeSlots);
+    if (manager->activeList) free(manager->activeList);
+    if (manager->activeIndex) free(manager->activeIndex);
+    if (manager->rowSlots) free(manager->rowSlots);
+    if (manager->sleepStart) free(manager->sleepStart);
+    timer_wheel_destroy((timer_wheel_t *)&manager->wakeTimers);
+    if (manager->passList) free(manager->passList);
+    if (manager->destroyQueue) free(manager->destroyQueue);
+    if (manager->flushList) free(manager->flushList);
+    if (manager->splashes) free(manager->splashes);
+    entity_hot_close((entity_hot_t *)&manager->hot);
+    for (i = 0; i < ENTITY_TYPE_COUNT; i++) {
+        buf_pool_destroy((buf_pool_t *)&manager->statePools[i]);
+    }
+    if (manager->cmdBuffers) {
+        for (i = 0; i < manager->numCmdBuffers; i++) {
+            if (manager->cmdBuffers[i].cmds) free(manager->cmdBuffers[i].cmds);
+        }
+        free(manager->cmdBuffers);
+    }
 }
 
-entity_t *entity_new(entity_manager_t *manager, const int64_t id) {
-    uint32_t i;
-    entity_t* ent;
-    if (!manager->ents) 
-        return NULL;
+static entity_handle_t entity_make_handle(const entity_manager_t *manager, const uint32_t slot) {
+    return ((entity_handle_t) manager->generations[slot] << ENTITY_HANDLE_INDEX_BITS) | slot;
+}
 
-    for (i = 0; i < manager->maxEnts; i++) {
-        ent = &manager->ents[i];
-        if (ent->_inUse > 0) continue;
+static void entity_active_swap(entity_manager_t *manager, const uint32_t posA, const uint32_t posB) {
+    const uint32_t slotA = manager->activeList[posA], slotB = manager->activeList[posB];
 
-        ent->_inUse = 1;
-        ent->id = id;
-        ent->draw = entity_draw;
-        ent->scale = gfc_vector2d(1, 1);
-        ent->layers = 0xFFFF;
+    manager->activeList[posA] = slotB;
+    manager->activeIndex[slotB] = posA;
+    manager->activeList[posB] = slotA;
+    manager->activeIndex[slotA] = posB;
+}
 
-        if (id < 0) {
-            return ent; // Negative IDs are not mapped, client side
+static void entity_release_slot(entity_manager_t *manager, const uint32_t slot) {
+    uint32_t pos = manager->activeIndex[slot];
+    uint32_t last;
+
+    // Close the gap in the awake prefix first, the slot then sits at the head of the asleep part
+    if (pos < manager->numAwake) {
+        entity_active_swap(manager, pos, --manager->numAwake);
+        pos = manager->numAwake;
+    }
+
+    last = manager->activeList[--manager->numEnts];
+    manager->activeList[pos] = last;
+    manager->activeIndex[last] = pos;
+    manager->freeSlots[manager->numFreeSlots++] = slot;
+    manager->hot.layers[manager->hot.rows[slot]] = 0;
+
+    if (++manager->generations[slot] == 0) {
+        manager->generations[slot] = 1; // Skip 0 on wrap so ENTITY_HANDLE_NULL never resolves
+    }
+}
+
+static int entity_id_find(const entity_manager_t *manager, const int64_t id, uint32_t *pos) {
+    uint32_t key;
+    if (id < 0 || id > UINT32_MAX) return 0;
+
+    key = (uint32_t) id & ENTITY_HANDLE_INDEX_MASK;
+    if (key >= manager->idSparseSize) return 0;
+
+    *pos = manager->idSparse[key];
+    return *pos < manager->numIds && manager->idDense[*pos].id == id;
+}
+
+static void entity_id_unmap(entity_manager_t *manager, const int64_t id, const uint32_t slot) {
+    entity_id_entry_t *last;
+    uint32_t pos;
+    if (!entity_id_find(manager, id, &pos) || manager->idDense[pos].slot != slot) {
+        return; // Not mapped, or the ID was since claimed by a newer entity
+    }
+
+    last = &manager->idDense[--manager->numIds];
+    manager->idDense[pos] = *last;
+    manager->idSparse[(uint32_t) last->id & ENTITY_HANDLE_INDEX_MASK] = pos;
+}
+
+static int entity_id_map(entity_manager_t *manager, const int64_t id, const uint32_t slot) {
+    uint32_t key, pos, newSize, *newSparse;
+    if (id < 0) {
+        return 1; // Negative IDs are client side only and reached through handles
+    }
+
+    if (id > UINT32_MAX) {
+        log_error("Entity ID %ld does not fit an entity handle", (long) id);
+        return 0;
+    }
+
+    key = (uint32_t) id & ENTITY_HANDLE_INDEX_MASK;
+    if (key >= manager->idSparseSize) {
+        // Only remote IDs land here, bounded by the handle index bits of the sending manager
+        newSize = manager->idSparseSize ? manager->idSparseSize : ENTITY_CHUNK_SIZE;
+        while (key >= newSize) newSize *= 2;
+        if (newSize > ENTITY_HANDLE_MAX_SLOTS) newSize = ENTITY_HANDLE_MAX_SLOTS;
+
+        newSparse = realloc(manager->idSparse, sizeof(uint32_t) * newSize);
+        if (!newSparse) {
+            log_error("Failed to grow entity ID map");
+            return 0;
         }
+        manager->idSparse = newSparse;
+        manager->idSparseSize = newSize;
+    }
 
-        if (id >= manager->maxIdSlots) {
-            uint64_t newMaxIdSlots = manager->maxIdSlots * 2;
-            uint64_t *newIdToSlot = malloc(sizeof(uint64_t) * newMaxIdSlots);
-            if (!newIdToSlot) {
-                log_error("Failed to reallocate memory for ID to slot mapping");
-                ent->_inUse = 0; // Mark entity as not in use since we failed to map its ID
-                return NULL;
-            }
+    pos = manager->idSparse[key];
+    if (pos < manager->numIds && ((uint32_t) manager->idDense[pos].id & ENTITY_HANDLE_INDEX_MASK) == key) {
+        // Same key, either a re-sent spawn or a newer generation of the remote slot, take it over
+        manager->idDense[pos].id = id;
+        manager->idDense[pos].slot = slot;
+        return 1;
+    }
 
-            memcpy(newIdToSlot, manager->idToSlot, sizeof(uint64_t) * manager->maxIdSlots);
-            memset(newIdToSlot + manager->maxIdSlots, 0, sizeof(uint64_t) * (newMaxIdSlots - manager->maxIdSlots));
-            free(manager->idToSlot);
-            manager->idToSlot = newIdToSlot;
+    if (manager->numIds >= manager->capacity) {
+        log_error("Entity ID map is full");
+        return 0;
+    }
+
+    pos = manager->numIds++;
+    manager->idDense[pos].id = id;
+    manager->idDense[pos].slot = slot;
+    manager->idSparse[key] = pos;
+    return 1;
+}
+
+void entity_register_type(const entity_type_t type, const entity_type_ops_t *ops) {
+    if (type >= ENTITY_TYPE_COUNT) {
+        log_error("Cannot register unknown entity type %d", type);
+        return;
+    }
+    entity_types[type] = ops;
+}
+
+entity_t *entity_new(entity_manager_t *manager, const int64_t id) {
+    uint32_t slot;
+    entity_t* ent;
+    if (!manager)
+        return NULL;
+
+    if (manager->numFreeSlots == 0 && !entity_grow(manager)) {
+        if (manager->allocFailures++ == 0) {
+            log_error("Entity pool is full at %u of %u slots, spawns will fail until slots are freed",
+                manager->capacity, manager->maxEnts);
         }
+        return NULL;
+    }
 
-        manager->idToSlot[ent->id] = i; // Map ID to slot index
+    slot = manager->freeSlots[--manager->numFreeSlots];
+    ent = entity_at(manager, slot);
+    manager->activeIndex[slot] = manager->numEnts;
+    manager->activeList[manager->numEnts++] = slot;
+    entity_active_swap(manager, manager->activeIndex[slot], manager->numAwake++); // Spawns start awake
+    if (manager->numEnts > manager->highWater) manager->highWater = manager->numEnts;
 
-        return ent;
+    ent->_inUse = 1;
+    ent->id = id == ENTITY_ID_AUTO ? (int64_t) entity_make_handle(manager, slot) : id;
+    ent->type = ENTITY_TYPE_STATIC;
+    ent->scale = gfc_vector2d(1, 1);
+    ent->layers = 0xFFFF;
+    entity_sync_hot(manager, ent);
+
+    if (!entity_id_map(manager, ent->id, slot)) {
+        ent->_inUse = 0; // Mark entity as not in use since we failed to map its ID
+        entity_release_slot(manager, slot);
+        return NULL;
     }
 
-    log_error("No free entity slots available");
-    return NULL;
+    return ent;
 }
 
 entity_t *entity_new_animated(const entity_manager_t *manager, const int64_t id) {
@@ -99,17 +454,15 @@ entity_t *entity_new_animated(const entity_manager_t *manager, const int64_t id)
     if (!ent) return NULL;
 
     ent->flags |= ENT_FLAG_ANIMATED;
-    ent->draw = entity_draw_animated;
-    ent->update = entity_update_animated;
+    ent->type = ENTITY_TYPE_ANIMATED;
 
     return ent;
 }
 
 void entity_free(const entity_manager_t *entityManager, entity_t* ent) {
+    uint32_t slot;
     if (!ent) return;
 
-     // Clear ID to slot mapping if applicable
-
     if (ent->flags & ENT_FLAG_ANIMATED) {
         // Assuming model is of type AnimatedSprite when ENT_FLAG_ANIMATED is set
         AnimatedSprite *animatedSprite = (AnimatedSprite *)ent->model;
@@ -120,43 +473,436 @@ void entity_free(const entity_manager_t *entityManager, entity_t* ent) {
         if (ent->model) gf2d_sprite_free(ent->model);
     }
 
-    if (ent->destroy) ent->destroy(entityManager, ent);
+    if (entity_ops(ent->type)->destroy) entity_ops(ent->type)->destroy(entityManager, ent);
     if (ent->data) {
-        free(ent->data);
+        if (!entityManager || !buf_pool_free((buf_pool_t *)&entityManager->statePools[ent->type], ent->data)) {
+            free(ent->data); // Heap allocated, either the type has no pool or its pool had overflowed
+        }
         ent->data = NULL;
     }
 
+    slot = ent->_slot;
+    if (ent->_inUse && entityManager) {
+        timer_wheel_cancel((timer_wheel_t *)&entityManager->wakeTimers, slot);
+        entity_id_unmap((entity_manager_t *)entityManager, ent->id, slot);
+        entity_release_slot((entity_manager_t *)entityManager, slot);
+    }
     memset(ent, 0, sizeof(entity_t));
+    ent->_slot = slot; // The slot belongs to the memory, not the entity
+}
+
+void *entity_new_state(const entity_manager_t *entityManager, entity_t *ent, const entity_type_t type) {
+    buf_pool_t *pool;
+    void *state;
+    if (!entityManager || !ent || type >= ENTITY_TYPE_COUNT) return NULL;
+    if (!entity_ops(type)->stateSize) {
+        log_error("Entity type %u has no state size registered", type);
+        return NULL;
+    }
+
+    pool = (buf_pool_t *)&entityManager->statePools[type];
+    state = buf_pool_alloc(pool);
+    if (!state) {
+        // Overflow keeps the spawn working, the pool's overflow count says the pool size needs raising
+        if (pool->overflows == 1 && pool->capacity) {
+            log_warn("State pool for entity type %u is exhausted at %u, falling back to the heap", type, pool->capacity);
+        }
+        state = gfc_allocate_array(entity_ops(type)->stateSize, 1);
+        if (!state) {
+            log_error("Failed to allocate state for entity type %u", type);
+            return NULL;
+        }
+    }
+
+    ent->type = type;
+    ent->data = state;
+    return state;
+}
+
+const buf_pool_t *entity_get_state_pool(const entity_manager_t *manager, const entity_type_t type) {
+    if (!manager || type >= ENTITY_TYPE_COUNT) return NULL;
+    return &manager->statePools[type];
+}
+
+int entity_queue_splash(const entity_manager_t *entityManager, const entity_splash_t *splash) {
+    entity_manager_t *manager = (entity_manager_t *)entityManager;
+    entity_splash_t *newSplashes;
+    uint32_t newCapacity;
+    if (!manager || !splash) return 0;
+
+    if (manager->numSplashes >= manager->splashCapacity) {
+        newCapacity = manager->splashCapacity ? manager->splashCapacity * 2 : 64;
+        newSplashes = realloc(manager->splashes, sizeof(entity_splash_t) * newCapacity);
+        if (!newSplashes) {
+            log_error("Failed to grow splash queue");
+            return 0;
+        }
+        manager->splashes = newSplashes;
+        manager->splashCapacity = newCapacity;
+    }
+
+    manager->splashes[manager->numSplashes++] = *splash;
+    return 1;
+}
+
+entity_splash_t *entity_get_splashes(const entity_manager_t *manager, uint32_t *count) {
+    if (count) *count = manager ? manager->numSplashes : 0;
+    return manager ? manager->splashes : NULL;
+}
+
+void entity_clear_splashes(const entity_manager_t *manager) {
+    if (!manager) return;
+    ((entity_manager_t *)manager)->numSplashes = 0;
+}
+
+void entity_get_pool_stats(const entity_manager_t *manager, entity_pool_stats_t *stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(entity_pool_stats_t));
+    if (!manager) return;
+
+    stats->numEnts = manager->numEnts;
+    stats->highWater = manager->highWater;
+    stats->capacity = manager->capacity;
+    stats->limit = manager->maxEnts;
+    stats->numChunks = manager->numChunks;
+    stats->allocFailures = manager->allocFailures;
+    stats->numAsleep = manager->wakeTimers.count;
+}
+
+uint32_t entity_collides_with(entity_t *ent, entity_t *other) {
+    if (!ent || !entity_ops(ent->type)->collidesWith) return 0;
+    return entity_ops(ent->type)->collidesWith(ent, other);
+}
+
+uint32_t entity_on_collide(entity_t *ent, entity_t *other, const uint32_t type) {
+    if (!ent || !entity_ops(ent->type)->onCollide) return 1; // No handler, the collision stands
+    return entity_ops(ent->type)->onCollide(ent, other, type);
+}
+
+static void entity_wake_slot(entity_manager_t *manager, entity_t *ent, const uint32_t sleptTicks) {
+    ent->flags &= ~ENT_FLAG_ASLEEP;
+    entity_active_swap(manager, manager->activeIndex[ent->_slot], manager->numAwake++);
+    if (entity_ops(ent->type)->wake) entity_ops(ent->type)->wake(manager, ent, sleptTicks);
+}
+
+static void entity_wake_timer(void *userData, const uint32_t timer) {
+    entity_manager_t *manager = (entity_manager_t *)userData;
+    entity_t *ent = entity_at(manager, timer);
+
+    // Fired at the start of the tick the sleep ends on, that tick's passes are not missed
+    entity_wake_slot(manager, ent, (uint32_t) (manager->wakeTimers.now - manager->sleepStart[timer] - 1));
+}
+
+// Leaves the entity out of the think and update passes of the next ticks, sleeping again restarts the countdown.
+// Only call from serial code (update pass, deferred commands, packet handling), the parallel think pass must defer it
+void entity_sleep(const entity_manager_t *entityManager, entity_t *ent, const uint32_t ticks) {
+    entity_manager_t *manager = (entity_manager_t *)entityManager;
+    if (!manager || !ent || !ent->_inUse || !entity_owned(manager, ent)) return;
+    if (ticks == 0) return;
+
+    if (!(ent->flags & ENT_FLAG_ASLEEP)) {
+        manager->sleepStart[ent->_slot] = manager->wakeTimers.now;
+        ent->flags |= ENT_FLAG_ASLEEP;
+        entity_active_swap(manager, manager->activeIndex[ent->_slot], --manager->numAwake);
+    }
+    timer_wheel_schedule(&manager->wakeTimers, ent->_slot, ticks + 1); // Due on the think pass after the last skipped tick
+}
+
+// Ends a sleep early, for events that change what a sleeping entity has to do. Same threading rule as entity_sleep
+void entity_wake(const entity_manager_t *entityManager, entity_t *ent) {
+    entity_manager_t *manager = (entity_manager_t *)entityManager;
+    if (!manager || !ent || !(ent->flags & ENT_FLAG_ASLEEP) || !entity_owned(manager, ent)) return;
+
+    timer_wheel_cancel(&manager->wakeTimers, ent->_slot);
+    entity_wake_slot(manager, ent, (uint32_t) (manager->wakeTimers.now - manager->sleepStart[ent->_slot]));
+}
+
+static uint32_t entity_build_pass_list(const entity_manager_t *entityManager, const uint8_t forThink,
+    uint32_t typeStart[ENTITY_TYPE_COUNT + 1]) {
+    entity_manager_t *manager = (entity_manager_t *)entityManager;
+    uint32_t cursor[ENTITY_TYPE_COUNT] = {0};
+    uint8_t inPass[ENTITY_TYPE_COUNT];
+    uint32_t i, type, total = 0;
+    entity_t *ent;
+
+    if (!entity_reserve_list(&manager->passList, &manager->passCapacity, manager->capacity)) {
+        memset(typeStart, 0, sizeof(uint32_t) * (ENTITY_TYPE_COUNT + 1));
+        return 0;
+    }
+
+    for (type = 0; type < ENTITY_TYPE_COUNT; type++) {
+        inPass[type] = forThink ? entity_ops(type)->thinkBatch != NULL : entity_ops(type)->updateBatch != NULL;
+    }
+
+    // The think pass opens the tick, entities whose sleep ends now rejoin before the list is built
+    if (forThink) {
+        timer_wheel_advance(&manager->wakeTimers, entity_wake_timer, manager);
+    }
+
+    // Counting sort by type so every type runs as one contiguous batch, sleeping entities are past numAwake
+    for (i = 0; i < manager->numAwake; i++) {
+        ent = entity_at(manager, manager->activeList[i]);
+        if (inPass[ent->type]) cursor[ent->type]++;
+    }
+
+    for (type = 0; type < ENTITY_TYPE_COUNT; type++) {
+        typeStart[type] = total;
+        total += cursor[type];
+        cursor[type] = typeStart[type];
+    }
+    typeStart[ENTITY_TYPE_COUNT] = total;
+
+    for (i = 0; i < manager->numAwake; i++) {
+        ent = entity_at(manager, manager->activeList[i]);
+        if (inPass[ent->type]) manager->passList[cursor[ent->type]++] = ent;
+    }
+    return total;
+}
+
+static void entity_think_list(const entity_manager_t *manager, const uint32_t typeStart[ENTITY_TYPE_COUNT + 1]) {
+    uint32_t type;
+
+    for (type = 0; type < ENTITY_TYPE_COUNT; type++) {
+        if (typeStart[type + 1] == typeStart[type]) continue;
+        entity_ops(type)->thinkBatch(manager, manager->passList + typeStart[type], typeStart[type + 1] - typeStart[type]);
+    }
 }
 
 void entity_think_all(const entity_manager_t *manager) {
-    size_t i;
+    uint32_t typeStart[ENTITY_TYPE_COUNT + 1];
+    if (manager->numEnts == 0) return; // Idle matches skip the pass entirely
+
+    entity_build_pass_list(manager, 1, typeStart);
+    entity_think_list(manager, typeStart);
+}
+
+void entity_defer(const entity_manager_t *entityManager, entity_t *ent, const entity_deferred_fn fn,
+    const void *payload, const size_t size) {
+    entity_cmd_buffer_t *buffer = t_cmdBuffer;
+    entity_cmd_t *cmd, *newCmds;
+    uint32_t newCapacity;
+    if (!ent || !fn) return;
+
+    if (size > ENTITY_DEFERRED_PAYLOAD_SIZE) {
+        log_error("Deferred entity payload of %zu bytes exceeds limit of %d", size, ENTITY_DEFERRED_PAYLOAD_SIZE);
+        return;
+    }
+
+    if (!buffer) {
+        fn(entityManager, ent, payload); // Not in a parallel phase, apply right away
+        return;
+    }
+
+    if (buffer->count >= buffer->capacity) {
+        newCapacity = buffer->capacity ? buffer->capacity * 2 : 64;
+        newCmds = realloc(buffer->cmds, sizeof(entity_cmd_t) * newCapacity);
+        if (!newCmds) {
+            log_error("Failed to grow deferred entity command buffer");
+            return;
+        }
+        buffer->cmds = newCmds;
+        buffer->capacity = newCapacity;
+    }
+
+    cmd = &buffer->cmds[buffer->count++];
+    cmd->order = t_cmdOrder;
+    cmd->handle = entity_get_handle(entityManager, ent);
+    cmd->fn = fn;
+    if (payload && size) memcpy(cmd->payload, payload, size);
+}
+
+static void entity_think_worker(void *userData, const uint32_t workerIndex, const uint32_t numWorkers) {
+    entity_think_job_t *job = (entity_think_job_t *)userData;
+    entity_manager_t *manager = job->manager;
+    uint32_t start, end, i, runEnd, type;
+
+    if (workerIndex != 0) {
+        g_game = *job->game; // g_game is thread local, workers read a copy of the tick thread's view
+    }
+
+    t_cmdBuffer = &manager->cmdBuffers[workerIndex];
+    while ((start = atomic_u32_fetch_add_relaxed(&job->nextIndex, ENTITY_PARALLEL_BLOCK_SIZE)) < job->count) {
+        end = start + ENTITY_PARALLEL_BLOCK_SIZE;
+        if (end > job->count) end = job->count;
+
+        // Split the block at type boundaries and run each piece through its type's batch
+        for (i = start; i < end; i = runEnd) {
+            for (type = 0; job->typeStart[type + 1] <= i; type++);
+            runEnd = job->typeStart[type + 1] < end ? job->typeStart[type + 1] : end;
+
+            // Commands from one run are recorded in pass order, keying them by the run start keeps the merge serial
+            t_cmdOrder = i;
+            entity_ops(type)->thinkBatch(manager, manager->passList + i, runEnd - i);
+        }
+    }
+    t_cmdBuffer = NULL;
+}
+
+static void entity_commit_deferred(entity_manager_t *manager, const uint32_t numBuffers) {
+    entity_cmd_buffer_t *buffer, *best;
+    entity_cmd_t *cmd;
     entity_t *ent;
-    for (i = 0; i < manager->maxEnts; i++) {
-        ent = &manager->ents[i];
-        if (ent->_inUse == 0 || !ent->think) continue;
-        ent->think(manager, ent);
+    uint32_t i;
+
+    // Each buffer is already sorted by order, merging them replays the serial think order
+    while (1) {
+        best = NULL;
+        for (i = 0; i < numBuffers; i++) {
+            buffer = &manager->cmdBuffers[i];
+            if (buffer->head >= buffer->count) continue;
+            if (!best || buffer->cmds[buffer->head].order < best->cmds[best->head].order) {
+                best = buffer;
+            }
+        }
+
+        if (!best) break;
+
+        cmd = &best->cmds[best->head++];
+        ent = entity_resolve(manager, cmd->handle);
+        if (!ent) continue; // Freed earlier in the commit
+        cmd->fn(manager, ent, cmd->payload);
+    }
+}
+
+void entity_think_all_parallel(entity_manager_t *manager, struct worker_pool_s *pool) {
+    entity_think_job_t job;
+    entity_cmd_buffer_t *newBuffers;
+    uint32_t typeStart[ENTITY_TYPE_COUNT + 1];
+    uint32_t i, count, numWorkers;
+    if (manager->numEnts == 0) return;
+
+    numWorkers = worker_pool_get_size(pool);
+    if (numWorkers > manager->numCmdBuffers) {
+        newBuffers = realloc(manager->cmdBuffers, sizeof(entity_cmd_buffer_t) * numWorkers);
+        if (!newBuffers) {
+            log_error("Failed to allocate deferred entity command buffers");
+            entity_think_all(manager);
+            return;
+        }
+        memset(newBuffers + manager->numCmdBuffers, 0, sizeof(entity_cmd_buffer_t) * (numWorkers - manager->numCmdBuffers));
+        manager->cmdBuffers = newBuffers;
+        manager->numCmdBuffers = numWorkers;
+    }
+
+    count = entity_build_pass_list(manager, 1, typeStart);
+    if (numWorkers <= 1 || count < ENTITY_PARALLEL_MIN_ENTITIES) {
+        entity_think_list(manager, typeStart);
+        return;
     }
+
+    for (i = 0; i < numWorkers; i++) {
+        manager->cmdBuffers[i].count = 0;
+        manager->cmdBuffers[i].head = 0;
+    }
+
+    job.manager = manager;
+    job.game = &g_game;
+    job.count = count;
+    job.typeStart = typeStart;
+    atomic_u32_init(&job.nextIndex, 0);
+    worker_pool_run(pool, entity_think_worker, &job);
+
+    entity_commit_deferred(manager, numWorkers);
 }
+
 void entity_update_all(const entity_manager_t *manager, const float deltaTime) {
-    size_t i;
+    uint32_t typeStart[ENTITY_TYPE_COUNT + 1];
+    uint32_t type;
+    if (manager->numAwake == 0) return; // The think pass already ran the wake timers
+
+    entity_build_pass_list(manager, 0, typeStart);
+    for (type = 0; type < ENTITY_TYPE_COUNT; type++) {
+        if (typeStart[type + 1] == typeStart[type]) continue;
+        entity_ops(type)->updateBatch(manager, manager->passList + typeStart[type],
+            typeStart[type + 1] - typeStart[type], deltaTime);
+    }
+}
+
+static void entity_push_destroy(const entity_manager_t *entityManager, entity_t *ent, const void *payload) {
+    entity_manager_t *manager = (entity_manager_t *)entityManager;
+    if (manager->numDestroyQueued >= manager->capacity) {
+        log_error("Entity destroy queue is full");
+        return;
+    }
+    manager->destroyQueue[manager->numDestroyQueued++] = entity_get_handle(manager, ent);
+}
+
+void entity_queue_destroy(const entity_manager_t *entityManager, entity_t *ent) {
+    if (!entityManager || !ent || !ent->_inUse) return;
+    if (ent->flags & ENT_FLAG_PENDING_FREE) return; // Already queued
+
+    // The flag hides the entity from the remaining batches, the queue push waits for the commit when parallel
+    ent->flags |= ENT_FLAG_PENDING_FREE;
+    entity_defer(entityManager, ent, entity_push_destroy, NULL, 0);
+}
+
+uint32_t entity_flush_destroyed(const entity_manager_t *entityManager) {
+    entity_manager_t *manager = (entity_manager_t *)entityManager;
+    uint32_t counts[ENTITY_TYPE_COUNT] = {0};
+    uint32_t typeStart[ENTITY_TYPE_COUNT + 1];
+    uint32_t i, type, count, total = 0, numFreed = 0;
     entity_t *ent;
-    for (i = 0; i < manager->maxEnts; i++) {
-        ent = &manager->ents[i];
-        if (ent->_inUse == 0 || !ent->update) continue;
-        ent->update(manager, ent, deltaTime);
+
+    if (!entity_reserve_list(&manager->flushList, &manager->flushCapacity, manager->capacity)) {
+        return 0; // Retried next flush, the queue is left as is
     }
+
+    // Destroy callbacks may queue more entities (a stash clearing the world), keep going until the queue is empty
+    while (manager->numDestroyQueued > 0) {
+        count = 0;
+        for (i = 0; i < manager->numDestroyQueued; i++) {
+            ent = entity_resolve(manager, manager->destroyQueue[i]);
+            if (!ent) continue; // Freed directly since it was queued
+            manager->destroyQueue[count++] = manager->destroyQueue[i];
+            counts[ent->type]++;
+        }
+        manager->numDestroyQueued = 0;
+
+        total = 0;
+        for (type = 0; type < ENTITY_TYPE_COUNT; type++) {
+            typeStart[type] = total;
+            total += counts[type];
+            counts[type] = typeStart[type];
+        }
+        typeStart[ENTITY_TYPE_COUNT] = total;
+
+        for (i = 0; i < count; i++) {
+            ent = entity_resolve(manager, manager->destroyQueue[i]);
+            manager->flushList[counts[ent->type]++] = ent;
+        }
+        memset(counts, 0, sizeof(counts));
+
+        for (type = 0; type < ENTITY_TYPE_COUNT; type++) {
+            if (typeStart[type + 1] == typeStart[type] || !entity_ops(type)->despawnBatch) continue;
+            entity_ops(type)->despawnBatch(manager, manager->flushList + typeStart[type], typeStart[type + 1] - typeStart[type]);
+        }
+
+        // Frees swap-remove from activeList and push onto the free stack, nothing is scanned per entity
+        for (i = 0; i < total; i++) {
+            ent = manager->flushList[i];
+            if (!ent->_inUse || !(ent->flags & ENT_FLAG_PENDING_FREE)) continue; // Freed by an earlier destroy callback
+            entity_free(manager, ent);
+            numFreed++;
+        }
+    }
+
+    return numFreed;
 }
 
-void entity_update_animated(const entity_manager_t *entityManager, entity_t *ent, float deltaTime) {
-    if (!ent) return;
-    if (!(ent->flags & ENT_FLAG_ANIMATED)) return;
+void entity_update_animated_batch(const entity_manager_t *entityManager, entity_t **ents, const uint32_t count,
+    const float deltaTime) {
+    AnimatedSprite *animatedSprite;
+    uint32_t i;
 
-    // Assuming model is of type AnimatedSprite when ENT_FLAG_ANIMATED is set
-    AnimatedSprite *animatedSprite = (AnimatedSprite *)ent->model;
-    if (!animatedSprite) return;
+    for (i = 0; i < count; i++) {
+        if (entity_batch_skip(ents[i])) continue;
 
-    animation_state_update(animatedSprite->state, deltaTime);
+        // Assuming model is of type AnimatedSprite when ENT_FLAG_ANIMATED is set
+        animatedSprite = (AnimatedSprite *)ents[i]->model;
+        if (!animatedSprite) continue;
+
+        animation_state_update(animatedSprite->state, deltaTime);
+    }
 }
 
 void entity_draw(const entity_manager_t *entityManager, entity_t *ent) {
@@ -171,52 +917,33 @@ int64_t entity_next_id(entity_manager_t *entityManager) {
     if (g_game.role == GAME_ROLE_CLIENT) {
         return -1; // Use negative IDs for client-side entities
     } else {
-        return entityManager->nextId++; // Use positive IDs for server-side entities
+        return ENTITY_ID_AUTO; // Server-side entities are identified by their handle
     }
 }
 
 void entity_set_id(entity_manager_t *entityManager, entity_t *ent, int64_t id) {
-    uint32_t i;
+    uint32_t slot;
     if (!ent) return;
-    ent->id = id;
-
-    if (id < 0) {
-        return; // Negative IDs are not mapped, client side
-    }
-
-    for (i = 0; i < entityManager->maxEnts; i++) {
-        if (&entityManager->ents[i] == ent) {
-            if (id >= entityManager->maxIdSlots) {
-                uint64_t newMaxIdSlots = entityManager->maxIdSlots * 2;
-                uint64_t *newIdToSlot = malloc(sizeof(uint64_t) * newMaxIdSlots);
-                if (!newIdToSlot) {
-                    log_error("Failed to reallocate memory for ID to slot mapping");
-                    return;
-                }
-
-                memcpy(newIdToSlot, entityManager->idToSlot, sizeof(uint64_t) * entityManager->maxIdSlots);
-                memset(newIdToSlot + entityManager->maxIdSlots, 0, sizeof(uint64_t) * (newMaxIdSlots - entityManager->maxIdSlots));
-                free(entityManager->idToSlot);
-                entityManager->idToSlot = newIdToSlot;
-            }
 
-            entityManager->idToSlot[id] = i; // Map ID to slot index
-            return;
-        }
+    if (!entity_owned(entityManager, ent)) {
+        ent->id = id;
+        return; // Not owned by this manager
     }
-}
 
-entity_t * entity_get(const entity_manager_t *manager, int64_t id) {
-    if (!manager->idToSlot || id >= manager->maxIdSlots) {
-        return NULL;
-    }
+    slot = ent->_slot;
+    entity_id_unmap(entityManager, ent->id, slot);
+    ent->id = id;
+    entity_id_map(entityManager, id, slot);
+}
 
-    uint64_t slotIndex = manager->idToSlot[id];
-    if (slotIndex >= manager->maxEnts) {
+entity_t *entity_get(const entity_manager_t *manager, int64_t id) {
+    entity_t *ent;
+    uint32_t pos;
+    if (!manager || !entity_id_find(manager, id, &pos)) {
         return NULL;
     }
 
-    entity_t *ent = &manager->ents[slotIndex];
+    ent = entity_at(manager, manager->idDense[pos].slot);
     if (ent->_inUse == 0 || ent->id != id) {
         return NULL; // ID does not match, likely a stale reference
     }
@@ -224,6 +951,147 @@ entity_t * entity_get(const entity_manager_t *manager, int64_t id) {
     return ent;
 }
 
+entity_handle_t entity_get_handle(const entity_manager_t *manager, const entity_t *ent) {
+    if (!manager || !ent || !ent->_inUse) return ENTITY_HANDLE_NULL;
+    if (!entity_owned(manager, ent)) return ENTITY_HANDLE_NULL;
+
+    return entity_make_handle(manager, ent->_slot);
+}
+
+entity_t *entity_resolve(const entity_manager_t *manager, const entity_handle_t handle) {
+    uint32_t slot = handle & ENTITY_HANDLE_INDEX_MASK;
+    entity_t *ent;
+    if (!manager || slot >= manager->capacity) return NULL;
+    if (manager->generations[slot] != handle >> ENTITY_HANDLE_INDEX_BITS) return NULL; // Slot was freed since
+
+    ent = entity_at(manager, slot);
+    return ent->_inUse ? ent : NULL;
+}
+
+// For containers that store slots of live entities, like the world chunks, no generation check
+entity_t *entity_from_slot(const entity_manager_t *manager, const uint32_t slot) {
+    if (!manager || slot >= manager->capacity) return NULL;
+    return entity_at(manager, slot);
+}
+
+int entity_handle_valid(const entity_manager_t *manager, const entity_handle_t handle) {
+    return entity_resolve(manager, handle) != NULL;
+}
+
+const entity_hot_t *entity_get_hot(const entity_manager_t *manager) {
+    if (!manager) return NULL;
+    return &manager->hot;
+}
+
+void entity_sync_hot(const entity_manager_t *manager, const entity_t *ent) {
+    const entity_hot_t *hot;
+    uint32_t row;
+    if (!manager || !ent) return;
+    if (!entity_owned(manager, ent)) return;
+
+    hot = &manager->hot;
+    row = entity_hot_row(hot, ent);
+    hot->posX[row] = ent->position.x;
+    hot->posY[row] = ent->position.y;
+    hot->minX[row] = ent->position.x + ent->boundingBox.x;
+    hot->minY[row] = ent->position.y + ent->boundingBox.y;
+    hot->maxX[row] = hot->minX[row] + ent->boundingBox.w;
+    hot->maxY[row] = hot->minY[row] + ent->boundingBox.h;
+    hot->layers[row] = ent->layers;
+}
+
+// Interleaves the bits of two 16 bit coordinates, chunks close in the world get close keys
+static uint32_t entity_morton_key(uint32_t x, uint32_t y) {
+    x &= 0xFFFF;
+    x = (x | (x << 8)) & 0x00FF00FF;
+    x = (x | (x << 4)) & 0x0F0F0F0F;
+    x = (x | (x << 2)) & 0x33333333;
+    x = (x | (x << 1)) & 0x55555555;
+    y &= 0xFFFF;
+    y = (y | (y << 8)) & 0x00FF00FF;
+    y = (y | (y << 4)) & 0x0F0F0F0F;
+    y = (y | (y << 2)) & 0x33333333;
+    y = (y | (y << 1)) & 0x55555555;
+    return x | (y << 1);
+}
+
+static int entity_reorder_compare(const void *a, const void *b) {
+    const entity_reorder_key_t *keyA = a, *keyB = b;
+    if (keyA->key != keyB->key) return keyA->key < keyB->key ? -1 : 1;
+    return keyA->row < keyB->row ? -1 : keyA->row > keyB->row; // Equal keys keep their order so settled windows do not churn
+}
+
+uint32_t entity_reorder_spatial(entity_manager_t *manager) {
+    entity_reorder_key_t *keys;
+    entity_hot_t *hot;
+    float *values;
+    uint32_t *slots;
+    uint16_t *layers;
+    uint32_t start, count, i, row, slot, moved = 0;
+    if (!manager || manager->capacity == 0) return 0;
+
+    start = manager->reorderCursor < manager->capacity ? manager->reorderCursor : 0;
+    count = manager->capacity - start;
+    if (count > ENTITY_REORDER_WINDOW) count = ENTITY_REORDER_WINDOW;
+
+    // Windows overlap by half, rows drift past window edges over successive calls until the whole table is sorted
+    manager->reorderCursor = start + count >= manager->capacity ? 0 : start + ENTITY_REORDER_WINDOW / 2;
+
+    keys = buf_tick_alloc(sizeof(entity_reorder_key_t) * count);
+    values = buf_tick_alloc(sizeof(float) * count * 6);
+    slots = buf_tick_alloc(sizeof(uint32_t) * count);
+    layers = buf_tick_alloc(sizeof(uint16_t) * count);
+    if (!keys || !values || !slots || !layers) return 0;
+
+    hot = &manager->hot;
+    for (i = 0; i < count; i++) {
+        row = start + i;
+        keys[i].row = row;
+        keys[i].key = hot->layers[row] ?
+            entity_morton_key((uint32_t) (pos_to_chunk_coord(hot->posX[row]) + ENTITY_REORDER_BIAS),
+                (uint32_t) (pos_to_chunk_coord(hot->posY[row]) + ENTITY_REORDER_BIAS)) :
+            ENTITY_REORDER_FREE_KEY;
+    }
+    qsort(keys, count, sizeof(entity_reorder_key_t), entity_reorder_compare);
+
+    // Gather the window in key order, then write it back over the same rows
+    for (i = 0; i < count; i++) {
+        row = keys[i].row;
+        if (row != start + i) moved++;
+        values[i] = hot->posX[row];
+        values[count + i] = hot->posY[row];
+        values[count * 2 + i] = hot->minX[row];
+        values[count * 3 + i] = hot->minY[row];
+        values[count * 4 + i] = hot->maxX[row];
+        values[count * 5 + i] = hot->maxY[row];
+        layers[i] = hot->layers[row];
+        slots[i] = manager->rowSlots[row];
+    }
+    if (!moved) return 0;
+
+    for (i = 0; i < count; i++) {
+        row = start + i;
+        hot->posX[row] = values[i];
+        hot->posY[row] = values[count + i];
+        hot->minX[row] = values[count * 2 + i];
+        hot->minY[row] = values[count * 3 + i];
+        hot->maxX[row] = values[count * 4 + i];
+        hot->maxY[row] = values[count * 5 + i];
+        hot->layers[row] = layers[i];
+        slot = slots[i];
+        manager->rowSlots[row] = slot;
+        hot->rows[slot] = row;
+    }
+
+    return moved;
+}
+
+void entity_set_position(const entity_manager_t *manager, entity_t *ent, const GFC_Vector2D position) {
+    if (!ent) return;
+    ent->position = position;
+    entity_sync_hot(manager, ent);
+}
+
 void entity_draw_animated(const entity_manager_t *entityManager, entity_t *ent) {
     GFC_Vector2D position;
     if (!ent) return;
@@ -250,10 +1118,10 @@ void entity_draw_animated(const entity_manager_t *entityManager, entity_t *ent)
 void entity_draw_all(const entity_manager_t *manager) {
     uint32_t i;
     entity_t *ent;
-    for (i = 0; i < manager->maxEnts; i++) {
-        ent = &manager->ents[i];
-        if (ent->_inUse == 0 || !ent->draw) continue;
-        ent->draw(manager, ent);
+    for (i = 0; i < manager->numEnts; i++) {
+        ent = entity_at(manager, manager->activeList[i]);
+        if (!entity_ops(ent->type)->draw) continue;
+        entity_ops(ent->type)->draw(manager, ent);
 
         entity_draw_debug(manager, ent);
     }
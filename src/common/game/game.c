@@ -1,3 +1,15 @@
 #include "common/game/game.h"
 
-__thread game_t g_game = {0};
\ No newline at end of file
+#include "common/game/enemy.h"
+#include "common/game/player.h"
+#include "common/game/projectile.h"
+#include "common/game/tower.h"
+
+__thread game_t g_game = {0};
+
+void game_register_entity_types(void) {
+    player_register_entity_type();
+    tower_register_entity_type();
+    enemy_register_entity_type();
+    projectile_register_entity_type();
+}
@@ -1,6 +1,7 @@
 #include "common/game/inventory.h"
 
 #include "gfc_types.h"
+#include "common/buffer/arena.h"
 #include "common/game/item.h"
 
 void inventory_init(inventory_t *inventory, uint32_t capacity) {
@@ -131,21 +132,23 @@ void inventory_clear(inventory_t *inventory) {
 }
 
 inventory_transaction_t * inventory_transaction_create(uint32_t numItems, uint8_t isAddition) {
-    inventory_transaction_t *transaction = gfc_allocate_array(sizeof(inventory_transaction_t), 1);
+    // Transactions are applied and synced within the tick that creates them
+    inventory_transaction_t *transaction = buf_tick_alloc(sizeof(inventory_transaction_t));
     if (!transaction) {
         return NULL;
     }
 
-    transaction->items = gfc_allocate_array(sizeof(item_t), numItems);
+    transaction->items = buf_tick_alloc(sizeof(item_t) * numItems);
     transaction->numItems = 0;
     transaction->capacity = numItems;
     transaction->isAddition = isAddition;
+    transaction->transient = 1;
 
     return transaction;
 }
 
 void inventory_transaction_destroy(inventory_transaction_t *transaction) {
-    if (transaction) {
+    if (transaction && !transaction->transient) {
         if (transaction->items) {
             free(transaction->items);
         }
@@ -161,10 +164,13 @@ void inventory_transaction_add_item(inventory_transaction_t *transaction, const
     }
 
     if (transaction->numItems >= transaction->capacity) {
-        newCapacity = transaction->capacity * 2;
-        newItems = gfc_allocate_array(sizeof(item_t), newCapacity);
+        newCapacity = transaction->capacity ? transaction->capacity * 2 : 1;
+        newItems = transaction->transient ? buf_tick_alloc(sizeof(item_t) * newCapacity) : gfc_allocate_array(sizeof(item_t), newCapacity);
+        if (!newItems) {
+            return;
+        }
         memcpy(newItems, transaction->items, sizeof(item_t) * transaction->capacity);
-        free(transaction->items);
+        if (!transaction->transient) free(transaction->items);
         transaction->items = newItems;
         transaction->capacity = newCapacity;
     }
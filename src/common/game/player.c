@@ -2,6 +2,7 @@
 #include "gfc_types.h"
 
 #include "common/logger.h"
+#include "common/buffer/arena.h"
 #include "common/network/packet/definitions.h"
 #include "common/network/packet/io.h"
 #include "common/game/player.h"
@@ -31,27 +32,17 @@ typedef struct player_snapshot_s {
 } player_snapshot_t;
 
 static uint8_t player_tile_allows_movement(const player_t *player, const GFC_Vector2D worldPos) {
-    tile_t *tile;
     if (!g_game.world) {
         return 0;
     }
 
-    tile = world_get_tile_at_position(g_game.world, worldPos, NULL);
-    if (!tile) {
-        return 0;
-    }
-
-    if (player && player->canFly) {
-        return tile->properties.flyable;
-    }
-
-    return tile->properties.walkable;
+    return world_test_tile_flag(g_game.world, worldPos, player && player->canFly ? TILE_FLAG_FLYABLE : TILE_FLAG_WALKABLE);
 }
 
 static float player_tile_speed_multiplier(const GFC_Vector2D worldPos) {
     tile_t *tile;
-    if (!g_game.world) {
-        return 1.0f;
+    if (!g_game.world || !world_test_tile_flag(g_game.world, worldPos, TILE_FLAG_MODIFY_SPEED)) {
+        return 1.0f; // Most tiles, answered by the flag planes without a tile lookup
     }
 
     tile = world_get_tile_at_position(g_game.world, worldPos, NULL);
@@ -72,6 +63,9 @@ static void player_apply_tile_effects(player_t *player, const GFC_Vector2D world
     player->onHarmfulTile = 0;
     player->harmfulTileFeedbackTimer = fmaxf(0.0f, player->harmfulTileFeedbackTimer - deltaTime);
 
+    if (!world_test_tile_flag(g_game.world, worldPos, TILE_FLAG_HARMFUL)) {
+        return;
+    }
     tile = world_get_tile_at_position(g_game.world, worldPos, &tileId);
     if (!tile) {
         return;
@@ -145,16 +139,13 @@ entity_t * player_entity_spawn(const entity_manager_t *entityManager, player_t *
 
     ent->layers = ENT_LAYER_PLAYER;
     ent->boundingBox = gfc_rect(-36, -36, 72, 72);
+    entity_sync_hot(entityManager, ent);
 
     world_add_entity(g_game.world, ent);
     ent->data = player;
     player->entity = ent;
 
-    ent->think = player_think;
-    ent->update = player_update;
-    ent->draw = player_draw;
-    ent->collidesWith = player_collides_with;
-    ent->onCollide = player_on_collide;
+    ent->type = ENTITY_TYPE_PLAYER;
 
     return ent;
 }
@@ -295,8 +286,8 @@ GFC_Vector2D player_move(player_t *player, world_t *world, GFC_Vector2D position
 
 void player_attack(player_t *player, struct world_s *world) {
     GFC_Vector2D endPos;
-    GFC_List *list;
-    uint32_t i;
+    collision_filter_t filter = { .layerMask = ENT_LAYER_RESOURCE, .solidOnly = 1 };
+    collision_hit_t hit;
     item_t *item;
     if (!player || !world) {
         return;
@@ -311,22 +302,18 @@ void player_attack(player_t *player, struct world_s *world) {
     gfc_vector2d_scale(endPos, endPos, 50); // TODO: range based on tool
     gfc_vector2d_add(endPos, player->position, endPos);
 
-    list = gfc_list_new();
-
-    collision_raycast_world(world, player->entity, player->position, endPos, list);
+    // A swing harvests the first resource it reaches
+    filter.source = player->entity;
+    if (!collision_raycast(world, player->position, endPos, &filter, &hit) || !hit.entity->data) {
+        return;
+    }
 
-    for (i = 0; i < gfc_list_count(list); i++) {
-        entity_t *hitEnt = (entity_t *)gfc_list_nth(list, i);
-        if (hitEnt->layers & ENT_LAYER_RESOURCE) {
-            item = (item_t *)hitEnt->data;
-            item = item_clone(item);
-            item->quantity = 2;
+    item = item_clone((item_t *)hit.entity->data);
+    item->quantity = 2;
 
-            inventory_transaction_t *trans = inventory_transaction_create(1, 1);
-            inventory_transaction_add_item(trans, item);
-            player_inventory_transaction(player, trans);
-        }
-    }
+    inventory_transaction_t *trans = inventory_transaction_create(1, 1);
+    inventory_transaction_add_item(trans, item);
+    player_inventory_transaction(player, trans);
 }
 
 int player_inventory_transaction(player_t *player, inventory_transaction_t *transaction) {
@@ -382,7 +369,7 @@ int player_try_build_tower(player_t *player, const struct tower_def_s *towerDef,
     tower->ownerPlayerID = player->id;
     tower->teamID = player->teamID;
 
-    s2c_tower_snapshot_packet_t *towerPkt = gfc_allocate_array(sizeof(s2c_tower_snapshot_packet_t), 1);
+    s2c_tower_snapshot_packet_t *towerPkt = buf_tick_alloc(sizeof(s2c_tower_snapshot_packet_t));
     tower_snapshot_data_t towerData = {
         .createData = {
             .entityID = entity->id,
@@ -489,6 +476,33 @@ void player_update(const entity_manager_t *entityManager, entity_t *ent, float d
     }
 }
 
+static void player_think_batch(const entity_manager_t *entityManager, entity_t **ents, const uint32_t count) {
+    uint32_t i;
+    for (i = 0; i < count; i++) {
+        if (entity_batch_skip(ents[i])) continue;
+        player_think(entityManager, ents[i]);
+    }
+}
+
+static void player_update_batch(const entity_manager_t *entityManager, entity_t **ents, const uint32_t count, const float deltaTime) {
+    uint32_t i;
+    for (i = 0; i < count; i++) {
+        if (entity_batch_skip(ents[i])) continue;
+        player_update(entityManager, ents[i], deltaTime);
+    }
+}
+
+void player_register_entity_type(void) {
+    static const entity_type_ops_t ops = {
+        .thinkBatch = player_think_batch,
+        .updateBatch = player_update_batch,
+        .draw = player_draw,
+        .collidesWith = player_collides_with,
+        .onCollide = player_on_collide
+    };
+    entity_register_type(ENTITY_TYPE_PLAYER, &ops);
+}
+
 void player_draw(const entity_manager_t *entityManager, entity_t *ent) {
     GFC_Vector2D position, centerPos, heldItemOffset, itemCenterPos;
     Sprite *playerSprite, *heldItemSprite;
@@ -499,7 +513,7 @@ void player_draw(const entity_manager_t *entityManager, entity_t *ent) {
 
     player_t *player = (player_t *)ent->data;
 
-    ent->position = player->position;
+    entity_set_position(entityManager, ent, player->position);
     gfc_vector2d_sub(position, ent->position, g_camera.position);
 
     playerSprite = ent->model;
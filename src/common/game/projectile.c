@@ -1,4 +1,7 @@
+#include <stdlib.h>
+
 #include "common/logger.h"
+#include "common/buffer/arena.h"
 #include "common/game/entity.h"
 #include "common/game/projectile.h"
 
@@ -10,10 +13,18 @@
 #include "common/game/collision.h"
 #include "common/game/enemy.h"
 #include "common/game/game.h"
+#include "common/network/packet/definitions.h"
+#include "common/network/packet/io.h"
 #include "server/server.h"
 
 extern uint8_t __INF_DAMAGE;
 
+typedef struct projectile_splash_resolve_s {
+    const entity_splash_t *splashes; // Impacts of the cluster being visited, bit i of a circle mask is splashes[i]
+    enemy_damage_entry_t entries[ENEMY_DAMAGE_BATCH_MAX];
+    uint16_t numEntries;
+} projectile_splash_resolve_t;
+
 void projectile_think(const entity_manager_t *entityManager, entity_t *ent);
 void projectile_update(const entity_manager_t *entityManager, entity_t *ent, float deltaTime);
 void projectile_draw(const entity_manager_t *entityManager, entity_t *ent);
@@ -38,7 +49,7 @@ int projectile_spawn(const entity_manager_t *entityManager, const float speed, c
     }
 
     // Initialize projectile state
-    projectile = (projectile_state_t *)gfc_allocate_array(sizeof(projectile_state_t), 1);
+    projectile = (projectile_state_t *)entity_new_state(entityManager, ent, ENTITY_TYPE_PROJECTILE);
     if (!projectile) {
         log_error("Failed to allocate memory for projectile state");
         entity_free(entityManager, ent);
@@ -51,26 +62,17 @@ int projectile_spawn(const entity_manager_t *entityManager, const float speed, c
     projectile->areaDamage = areaDamage;
     gfc_vector2d_copy(projectile->direction, direction);
     projectile->distanceTraveled.x = 0; projectile->distanceTraveled.y = 0;
-    projectile->sourceTower = sourceTower;
+    projectile->sourceTower = entity_get_handle(entityManager, sourceTower->entity);
     projectile->entity = ent;
 
-    world_add_entity(g_game.world, ent);
-
     // Set up the entity's properties
-    ent->think = projectile_think;
-    ent->update = projectile_update;
-    ent->draw = projectile_draw;
-    ent->destroy = projectile_destroy;
-    ent->collidesWith = projectile_collides_with;
-    ent->onCollide = projectile_on_collide;
-
     ent->layers = ENT_LAYER_PROJECTILE;
     ent->boundingBox = gfc_rect(-12, -12, 24, 24); // Example bounding box size for projectile, can be adjusted based on sprite
 
-    // Position the entity at the source tower's location
-    ent->position = sourceTower->worldPos;
+    // Position the entity at the source tower's location, the world files it by layer and position
+    entity_set_position(entityManager, ent, sourceTower->worldPos);
+    world_add_entity(g_game.world, ent);
     ent->rotation = gfc_vector2d_angle(direction) * 180.0f / M_PI;
-    ent->data = projectile;
 
     if (g_game.role == GAME_ROLE_CLIENT) {
         ent->model = gf2d_sprite_load_image(spriteModel);
@@ -108,12 +110,28 @@ void projectile_update(const entity_manager_t *entityManager, entity_t *ent, con
         }
     }
 
-    ent->position = pos; // Update position after successful move
+    entity_set_position(entityManager, ent, pos); // Update position after successful move
 
     // Check if the projectile has exceeded its range
     gfc_vector2d_add(projectile->distanceTraveled, projectile->distanceTraveled, movement);
     if (gfc_vector2d_magnitude(projectile->distanceTraveled) >= projectile->range) {
-        ent->think = entity_free;
+        entity_queue_destroy(entityManager, ent);
+    }
+}
+
+void projectile_think_batch(const entity_manager_t *entityManager, entity_t **ents, const uint32_t count) {
+    uint32_t i;
+    for (i = 0; i < count; i++) {
+        if (entity_batch_skip(ents[i])) continue;
+        projectile_think(entityManager, ents[i]);
+    }
+}
+
+void projectile_update_batch(const entity_manager_t *entityManager, entity_t **ents, const uint32_t count, const float deltaTime) {
+    uint32_t i;
+    for (i = 0; i < count; i++) {
+        if (entity_batch_skip(ents[i])) continue;
+        projectile_update(entityManager, ents[i], deltaTime);
     }
 }
 
@@ -140,8 +158,119 @@ uint32_t projectile_collides_with(entity_t *ent, entity_t *other) {
     return COLLISION_NONE; // No collision
 }
 
+static void projectile_apply_damage(const entity_manager_t *entityManager, entity_t *ent, const void *payload) {
+    enemy_state_t *enemy;
+    if (!ent || !ent->data || !payload) {
+        return;
+    }
+
+    enemy = (enemy_state_t *)ent->data;
+    if (__INF_DAMAGE) {
+        enemy->health = 0; // Instantly kill the enemy for testing purposes
+    } else {
+        enemy->health -= *(const float *)payload;
+    }
+    enemy->dirtyFlags |= ENEMY_DIRTY_HEALTH; // Mark enemy health as dirty to trigger update
+}
+
+static void projectile_queue_splash(const entity_manager_t *entityManager, entity_t *ent, const void *payload) {
+    entity_queue_splash(entityManager, (const entity_splash_t *)payload);
+}
+
+static int projectile_compare_splash(const void *a, const void *b) {
+    const entity_splash_t *splashA = (const entity_splash_t *)a, *splashB = (const entity_splash_t *)b;
+    const float minA = splashA->center.x - splashA->radius, minB = splashB->center.x - splashB->radius;
+    return (minA > minB) - (minA < minB);
+}
+
+static void projectile_send_damage(projectile_splash_resolve_t *resolve) {
+    s2c_enemy_damage_batch_packet_t *pkt;
+    if (resolve->numEntries == 0) {
+        return;
+    }
+
+    pkt = buf_tick_alloc(sizeof(s2c_enemy_damage_batch_packet_t));
+    if (pkt) {
+        create_s2c_enemy_damage_batch(pkt, resolve->entries, resolve->numEntries);
+        server_broadcast_packet_batch(&g_server, pkt);
+    }
+    resolve->numEntries = 0;
+}
+
+// Every impact of the cluster that reached the enemy lands as one hit
+static int projectile_visit_splash(entity_t *enemy, uint32_t circleMask, void *userData) {
+    projectile_splash_resolve_t *resolve = (projectile_splash_resolve_t *)userData;
+    enemy_state_t *state = (enemy_state_t *)enemy->data;
+    enemy_damage_entry_t *entry;
+    float damage = 0.0f;
+    if (!state) {
+        return 1;
+    }
+
+    for (; circleMask; circleMask &= circleMask - 1) {
+        damage += resolve->splashes[__builtin_ctz(circleMask)].damage;
+    }
+    if (__INF_DAMAGE) {
+        state->health = 0; // Instantly kill the enemy for testing purposes
+    } else {
+        state->health -= damage;
+    }
+
+    entry = &resolve->entries[resolve->numEntries++];
+    entry->enemyID = enemy->id;
+    entry->health = state->health;
+    if (resolve->numEntries == ENEMY_DAMAGE_BATCH_MAX) {
+        projectile_send_damage(resolve);
+    }
+    return 1;
+}
+
+void projectile_resolve_splashes(const entity_manager_t *entityManager) {
+    collision_filter_t filter = { .layerMask = ENT_LAYER_ENEMY, .typeMask = COLLISION_TYPE_BIT(ENTITY_TYPE_ENEMY) };
+    collision_circle_t circles[COLLISION_MAX_CIRCLES];
+    projectile_splash_resolve_t resolve;
+    entity_splash_t *splashes;
+    const entity_splash_t *area;
+    uint32_t start, end, k, count;
+    float maxX, minY, maxY;
+
+    splashes = entity_get_splashes(entityManager, &count);
+    if (count == 0) {
+        return;
+    }
+
+    // Sorted by left edge, impacts join a cluster while they overlap its bounds and share its walk of the world
+    qsort(splashes, count, sizeof(entity_splash_t), projectile_compare_splash);
+    resolve.numEntries = 0;
+    for (start = 0; start < count; start = end) {
+        area = &splashes[start];
+        maxX = area->center.x + area->radius;
+        minY = area->center.y - area->radius;
+        maxY = area->center.y + area->radius;
+        for (end = start + 1; end < count && end - start < COLLISION_MAX_CIRCLES; end++) {
+            area = &splashes[end];
+            if (area->center.x - area->radius > maxX || area->center.y - area->radius > maxY ||
+                area->center.y + area->radius < minY) {
+                break;
+            }
+            maxX = fmaxf(maxX, area->center.x + area->radius);
+            minY = fminf(minY, area->center.y - area->radius);
+            maxY = fmaxf(maxY, area->center.y + area->radius);
+        }
+
+        for (k = start; k < end; k++) {
+            circles[k - start].center = splashes[k].center;
+            circles[k - start].radius = splashes[k].radius;
+        }
+        resolve.splashes = splashes + start;
+        collision_visit_circles(g_game.world, circles, end - start, &filter, projectile_visit_splash, &resolve);
+    }
+    projectile_send_damage(&resolve);
+    entity_clear_splashes(entityManager);
+}
+
 uint32_t projectile_on_collide(entity_t *ent, entity_t *other, uint32_t collisionType) {
-    int i;
+    entity_splash_t splash;
     if (!ent || !other || !ent->data) {
         return 0;
     }
@@ -149,38 +278,22 @@ uint32_t projectile_on_collide(entity_t *ent, entity_t *other, uint32_t collisio
     projectile_state_t *projectile = (projectile_state_t *)ent->data;
 
     if (collisionType & COLLISION_EVENT) {
-        // Apply damage to the enemy
+        // Apply damage to the enemy, deferred since this runs in the parallel think phase
         if (other->data && g_game.role == GAME_ROLE_SERVER) {
-            enemy_state_t *enemy = (enemy_state_t *)other->data;
-
             if (projectile->areaDamage) {
-                GFC_List *enemyList = collision_get_entities_in_range(g_game.world, ent->position, projectile->range, ENT_LAYER_ENEMY);
-                for (i = 0; i < gfc_list_count(enemyList); i++) {
-                    entity_t *areaEnemyEnt = (entity_t *)gfc_list_nth(enemyList, i);
-                    if (!areaEnemyEnt || !areaEnemyEnt->data) {
-                        continue;
-                    }
-                    enemy_state_t *areaEnemy = (enemy_state_t *)areaEnemyEnt->data;
-                    if (__INF_DAMAGE) {
-                        areaEnemy->health = 0; // Instantly kill the enemy for testing purposes
-                    } else {
-                        areaEnemy->health -= projectile->damage;
-                    }
-                    areaEnemy->dirtyFlags |= ENEMY_DIRTY_HEALTH; // Mark enemy health as dirty to trigger update
-                }
+                // Queued for projectile_resolve_splashes, which lands the tick's impacts together
+                splash.center = ent->position;
+                splash.radius = projectile->range;
+                splash.damage = projectile->damage;
+                entity_defer(g_game.entityManager, ent, projectile_queue_splash, &splash, sizeof(entity_splash_t));
             } else {
                 // If not area damage, only apply to the first enemy hit
-                if (__INF_DAMAGE) {
-                    enemy->health = 0; // Instantly kill the enemy for testing purposes
-                }
-                enemy->health -= projectile->damage;
+                entity_defer(g_game.entityManager, other, projectile_apply_damage, &projectile->damage, sizeof(float));
             }
-
-            enemy->dirtyFlags |= ENEMY_DIRTY_HEALTH; // Mark enemy health as dirty to trigger update
         }
 
         // Destroy the projectile after hitting an enemy
-        ent->think = entity_free;
+        entity_queue_destroy(g_game.entityManager, ent);
     }
 
     return 1;
@@ -192,4 +305,18 @@ void projectile_destroy(const entity_manager_t *entityManager, entity_t *ent) {
     }
 
     world_remove_entity(g_game.world, ent);
-}
\ No newline at end of file
+}
+
+void projectile_register_entity_type(void) {
+    static const entity_type_ops_t ops = {
+        .thinkBatch = projectile_think_batch,
+        .updateBatch = projectile_update_batch,
+        .draw = projectile_draw,
+        .destroy = projectile_destroy,
+        .collidesWith = projectile_collides_with,
+        .onCollide = projectile_on_collide,
+        .stateSize = sizeof(projectile_state_t),
+        .statePoolSize = PROJECTILE_STATE_POOL_SIZE
+    };
+    entity_register_type(ENTITY_TYPE_PROJECTILE, &ops);
+}
@@ -1,6 +1,9 @@
+#include <math.h>
+
 #include "simple_json.h"
 #include "common/def.h"
 #include "common/logger.h"
+#include "common/buffer/arena.h"
 
 #include "common/game/tower.h"
 
@@ -14,8 +17,11 @@
 #include "common/network/packet/definitions.h"
 #include "common/network/packet/io.h"
 #include "server/server.h"
+#include "server/game/match.h"
 #include "server/game/player_manager.h"
 
+#define TOWER_IDLE_SCAN_INTERVAL 0.25f // Seconds between target scans of a tower with nothing in range
+
 struct tower_def_manager_s {
     tower_def_t *towerDefs;
     int numTowerDefs;
@@ -36,12 +42,13 @@ void tower_entity_think(const entity_manager_t *entityManager, entity_t *ent);
 void tower_entity_update(const entity_manager_t *entityManager, entity_t *ent, float deltaTime);
 void tower_entity_draw(const entity_manager_t *entityManager, entity_t *ent);
 void tower_entity_destroy(const entity_manager_t *entityManager, entity_t *ent);
+void tower_entity_wake(const entity_manager_t *entityManager, entity_t *ent, uint32_t sleptTicks);
 
 static player_t *tower_get_owner_player(const tower_state_t *tower) {
     if (!tower) {
         return NULL;
     }
-    return player_manager_get(g_server.playerManager, tower->ownerPlayerID);
+    return g_match ? player_manager_get(g_match->playerManager, tower->ownerPlayerID) : NULL;
 }
 
 static uint8_t tower_get_opponent_team_id(const tower_state_t *tower) {
@@ -148,6 +155,10 @@ tower_def_manager_t * tower_load_defs(const struct def_manager_s *defManager, ch
 
         sj_object_get_float(towerJson, "size", &def->size);
 
+        flag = 1;
+        sj_object_get_bool(towerJson, "solid", &flag);
+        def->solid = flag ? 1 : 0;
+
         valueArray = def_data_get_array(towerJson, "maxHealth");
         for (j = 0; j < TOWER_MAX_LEVEL; j++) {
             sj_get_float_value(def_data_array_get_nth(valueArray, j), &def->maxHealth[j]);
@@ -326,11 +337,7 @@ entity_t *tower_place(const entity_manager_t *entityManager, tower_manager_t *to
         return NULL;
     }
 
-    ent->think = tower_entity_think;
-    ent->update = tower_entity_update;
-    ent->draw = tower_entity_draw;
-    ent->destroy = tower_entity_destroy;
-    ent->collidesWith = tower_collides_with;
+    ent->type = ENTITY_TYPE_TOWER;
     ent->data = tower;
     tower->entity = ent;
 
@@ -344,10 +351,15 @@ entity_t *tower_place(const entity_manager_t *entityManager, tower_manager_t *to
 
     tower->worldPos = tower_snap_to_grid(tower->def, position);
     ent->position = tower->worldPos;
-    world_add_entity(g_game.world, ent);
-
     ent->layers = ENT_LAYER_TOWER;
     ent->boundingBox = gfc_rect(-def->size * TILE_SIZE / 2.0f, -def->size * TILE_SIZE / 2.0f, def->size * TILE_SIZE, def->size * TILE_SIZE);
+    if (def->solid) {
+        ent->flags |= ENT_FLAG_COLLIDE_SOLID; // Blocks enemies and their paths
+    }
+    entity_sync_hot(entityManager, ent);
+
+    // Added once its layer and bounds are final, the world files it by both
+    world_add_entity(g_game.world, ent);
 
     return ent;
 }
@@ -606,10 +618,64 @@ GFC_Vector2D tower_snap_to_grid(const tower_def_t *towerDef, const GFC_Vector2D
     return snappedPos;
 }
 
+static void tower_produce_gold(const entity_manager_t *entityManager, entity_t *ent, const void *payload) {
+    tower_state_t *tower = (tower_state_t *)ent->data;
+    player_t *player;
+    if (!tower) return;
+
+    player = tower_get_owner_player(tower);
+    if (player) {
+        inventory_transaction_t *trans = inventory_transaction_create(1, 1);
+        item_t *item = item_create(item_def_get(g_game.itemDefManager, "gold"), tower->def->productionAmount[tower->level]);
+        inventory_transaction_add_item(trans, item);
+        player_inventory_transaction(player, trans);
+        free(item);
+    }
+}
+
+typedef struct tower_target_search_s {
+    const entity_manager_t *entityManager;
+    const tower_state_t *tower;
+    GFC_Vector2D origin;
+    uint16_t targetLayer;
+    float lodHold; // Time until the tower scans again, enemies in range are kept at full rate at least this long
+    float bestDist;
+    GFC_Vector2D targetPos;
+    const item_t *item; // Resource of the closest target, gathering towers only
+    uint8_t found;
+} tower_target_search_t;
+
+static int tower_visit_target(entity_t *other, void *userData) {
+    tower_target_search_t *search = (tower_target_search_t *)userData;
+    const enemy_state_t *enemyState = NULL;
+    float dist;
+
+    if ((other->layers & ENT_LAYER_ENEMY) && other->data) {
+        // Enemies in range need full rate AI until the next scan, lodLevel and lodHoldTimer are not written during think
+        enemyState = (const enemy_state_t *)other->data;
+        if (enemyState->currentTeamID != search->tower->teamID &&
+            (enemyState->lodLevel != ENEMY_LOD_FULL || enemyState->lodHoldTimer < search->lodHold)) {
+            entity_defer(search->entityManager, other, enemy_lod_promote, &search->lodHold, sizeof(float));
+        }
+    }
+
+    if (!(other->layers & search->targetLayer)) return 1;
+    if (enemyState && enemyState->currentTeamID == search->tower->teamID) return 1; // Same team
+
+    dist = gfc_vector2d_magnitude_between_squared(search->origin, other->position);
+    if (dist < search->bestDist) {
+        search->bestDist = dist;
+        search->targetPos = other->position;
+        search->found = 1;
+        if (search->tower->def->type == TOWER_TYPE_GATHERING) {
+            search->item = (const item_t *)other->data;
+        }
+    }
+    return 1; // Every enemy in range may need promoting, never stop early
+}
+
 void tower_entity_think(const entity_manager_t *entityManager, entity_t *ent) {
-    uint32_t c, i;
-    GFC_Vector2D targetPos, pos;
-    float dist = FLT_MAX, enmyDist;
+    GFC_Vector2D pos;
     if (!ent) return;
     tower_state_t *tower = (tower_state_t *)ent->data;
     if (!tower) return;
@@ -619,52 +685,35 @@ void tower_entity_think(const entity_manager_t *entityManager, entity_t *ent) {
     }
 
     if (tower->health <= 0) {
-        ent->think = entity_free;
+        entity_queue_destroy(entityManager, ent);
         return;
     }
 
     if (tower->def->type == TOWER_TYPE_DEFENSIVE || tower->def->type == TOWER_TYPE_GATHERING) {
         tower->canShoot = 0;
         float range = tower->def->type == TOWER_TYPE_DEFENSIVE ? tower->def->weaponDefs[0].range[tower->level] : TILE_SIZE*3; // Defensive towers use weapon range, gathering towers have fixed range
-        GFC_List *enemiesInRange = collision_get_entities_in_range(g_game.world, ent->position, range, ENT_LAYER_ENEMY | ENT_LAYER_RESOURCE);
-        item_t *item = NULL;
-        c = gfc_list_count(enemiesInRange);
-        if (c == 0) {
-            return; // No enemies in range
-        }
-
-        for (i = 0; i < c; i++) {
-            entity_t *enemy = (entity_t *)gfc_list_get_nth(enemiesInRange, i);
-            if (((enemy_state_t*)enemy->data)->currentTeamID != tower->teamID && enemy && enemy->layers & (tower->def->type == TOWER_TYPE_DEFENSIVE ? ENT_LAYER_ENEMY : ENT_LAYER_RESOURCE)) {
-                enmyDist = gfc_vector2d_magnitude_between_squared(ent->position, enemy->position);
-                if (enmyDist < dist) {
-                    dist = enmyDist;
-                    targetPos = enemy->position;
-                    tower->canShoot = 1;
-                    if (tower->def->type == TOWER_TYPE_GATHERING) {
-                        item = (item_t *)enemy->data;
-                    }
-                }
-            }
-        }
-
+        collision_filter_t filter = { .layerMask = ENT_LAYER_ENEMY | ENT_LAYER_RESOURCE, .source = ent };
+        tower_target_search_t search = {
+            .entityManager = entityManager,
+            .tower = tower,
+            .origin = ent->position,
+            .targetLayer = tower->def->type == TOWER_TYPE_DEFENSIVE ? ENT_LAYER_ENEMY : ENT_LAYER_RESOURCE,
+            // tower_try_sleep keeps the tower out of think for up to a full cooldown, two ticks of slack cover the rounding
+            .lodHold = fmaxf(TOWER_IDLE_SCAN_INTERVAL, tower->def->type == TOWER_TYPE_DEFENSIVE ? tower->def->weaponDefs[0].fireRate[tower->level] : tower->def->productionRate[tower->level]) + 2.0f * g_game.deltaTime,
+            .bestDist = FLT_MAX
+        };
 
-        if (tower->canShoot) {
-            gfc_vector2d_sub(pos, targetPos, ent->position);
+        collision_visit_circle(g_game.world, ent->position, range, &filter, tower_visit_target, &search);
+        if (search.found) {
+            tower->canShoot = 1;
+            gfc_vector2d_sub(pos, search.targetPos, ent->position);
             gfc_vector2d_normalize(&pos);
             tower->shootDirection = pos;
-            if (item) tower->producingResource = item->def;
+            if (search.item) tower->producingResource = search.item->def;
         }
     } else if ((tower->def->type == TOWER_TYPE_GOLD_PRODUCTION || tower->def->type == TOWER_TYPE_STASH) && tower->productionCooldown <= 0) {
         tower->productionCooldown = tower->def->productionRate[tower->level];
-        player_t *player = tower_get_owner_player(tower);
-        if (player) {
-            inventory_transaction_t *trans = inventory_transaction_create(1, 1);
-            item_t *item = item_create(item_def_get(g_game.itemDefManager, "gold"), tower->def->productionAmount[tower->level]);
-            inventory_transaction_add_item(trans, item);
-            player_inventory_transaction(player, trans);
-            free(item);
-        }
+        entity_defer(entityManager, ent, tower_produce_gold, NULL, 0); // Touches the owner's inventory
     } else if (tower->def->type == TOWER_TYPE_UNIT_PRODUCTION) {
         uint8_t targetTeamID = tower_get_opponent_team_id(tower);
         if (targetTeamID != TEAM_NONE && g_game.state.teamStashAlive[targetTeamID - TEAM_ONE]) {
@@ -678,6 +727,34 @@ void tower_entity_think(const entity_manager_t *entityManager, entity_t *ent) {
     }
 }
 
+// A tower at full health with nothing to send only waits on a cooldown, leave it out of the passes until it is due.
+// Towers that found no target rescan every TOWER_IDLE_SCAN_INTERVAL. Damage and selection changes wake it early
+static void tower_try_sleep(const entity_manager_t *entityManager, entity_t *ent, const tower_state_t *tower, const float deltaTime) {
+    float wait;
+    if (deltaTime <= 0.0f || tower->dirtyFlags || tower->health < tower->def->maxHealth[tower->level]) return;
+
+    switch (tower->def->type) {
+        case TOWER_TYPE_DEFENSIVE:
+            wait = tower->canShoot ? tower->attackCooldown - deltaTime : TOWER_IDLE_SCAN_INTERVAL;
+            break;
+        case TOWER_TYPE_UNIT_PRODUCTION:
+            wait = tower->attackCooldown - deltaTime; // tower_try_shoot counts down once more on the tick it fires
+            break;
+        case TOWER_TYPE_GATHERING:
+            wait = tower->canShoot ? tower->productionCooldown : TOWER_IDLE_SCAN_INTERVAL;
+            break;
+        case TOWER_TYPE_GOLD_PRODUCTION:
+        case TOWER_TYPE_STASH:
+            wait = tower->productionCooldown;
+            break;
+        default:
+            return;
+    }
+
+    if (wait < deltaTime) return; // Due next tick anyway
+    entity_sleep(entityManager, ent, (uint32_t) ceilf(wait / deltaTime));
+}
+
 void tower_entity_update(const entity_manager_t *entityManager, entity_t *ent, float deltaTime) {
     if (!ent || ! ent->data) return;
     tower_state_t *tower = (tower_state_t *)ent->data;
@@ -685,7 +762,7 @@ void tower_entity_update(const entity_manager_t *entityManager, entity_t *ent, f
     if (g_game.role == GAME_ROLE_SERVER) {
         if (tower->canShoot) {
             if (tower->def->type == TOWER_TYPE_DEFENSIVE && tower_try_shoot(ent, deltaTime)) {
-                s2c_tower_snapshot_packet_t *towerPkt = gfc_allocate_array(sizeof(s2c_tower_snapshot_packet_t), 1);
+                s2c_tower_snapshot_packet_t *towerPkt = buf_tick_alloc(sizeof(s2c_tower_snapshot_packet_t));
                 tower_snapshot_data_t towerData = {
                     .shootData = {
                         .xDir = tower->shootDirection.x,
@@ -729,7 +806,7 @@ void tower_entity_update(const entity_manager_t *entityManager, entity_t *ent, f
                         ((enemy_state_t *)enemyEnt->data)->targetTeamID = targetTeamID;
                         ((enemy_state_t *)enemyEnt->data)->currentTeamID = tower->teamID;
 
-                        enemyPkt = gfc_allocate_array(sizeof(s2c_enemy_snapshot_packet_t), 1);
+                        enemyPkt = buf_tick_alloc(sizeof(s2c_enemy_snapshot_packet_t));
                         eventData.spawnData.enemyDefIndex = enemyDef->index;
                         eventData.spawnData.xPos = spawnPos.x;
                         eventData.spawnData.yPos = spawnPos.y;
@@ -738,7 +815,7 @@ void tower_entity_update(const entity_manager_t *entityManager, entity_t *ent, f
                         server_broadcast_packet_batch(&g_server, enemyPkt);
                     }
 
-                    s2c_tower_snapshot_packet_t *towerPkt = gfc_allocate_array(sizeof(s2c_tower_snapshot_packet_t), 1);
+                    s2c_tower_snapshot_packet_t *towerPkt = buf_tick_alloc(sizeof(s2c_tower_snapshot_packet_t));
                     tower_snapshot_data_t towerData = {
                         .shootData = {
                             .xDir = tower->shootDirection.x,
@@ -760,7 +837,7 @@ void tower_entity_update(const entity_manager_t *entityManager, entity_t *ent, f
         }
 
         if (tower->dirtyFlags & (TOWER_DIRTY_HEALTH | TOWER_DIRTY_SELECTION)) {
-            s2c_tower_snapshot_packet_t *towerPkt = gfc_allocate_array(sizeof(s2c_tower_snapshot_packet_t), 1);
+            s2c_tower_snapshot_packet_t *towerPkt = buf_tick_alloc(sizeof(s2c_tower_snapshot_packet_t));
             tower_snapshot_data_t towerData = {
                 .updateData = {
                     .health = tower->health,
@@ -773,6 +850,34 @@ void tower_entity_update(const entity_manager_t *entityManager, entity_t *ent, f
         }
 
         tower->productionCooldown -= deltaTime;
+        tower_try_sleep(entityManager, ent, tower, deltaTime);
+    }
+}
+
+void tower_entity_wake(const entity_manager_t *entityManager, entity_t *ent, const uint32_t sleptTicks) {
+    float slept;
+    if (!ent || !ent->data) return;
+    tower_state_t *tower = (tower_state_t *)ent->data;
+
+    // Cooldowns were not counted down while the tower was left out of the passes
+    slept = (float) sleptTicks * g_game.deltaTime;
+    tower->attackCooldown = fmaxf(0.0f, tower->attackCooldown - slept);
+    tower->productionCooldown -= slept;
+}
+
+void tower_think_batch(const entity_manager_t *entityManager, entity_t **ents, const uint32_t count) {
+    uint32_t i;
+    for (i = 0; i < count; i++) {
+        if (entity_batch_skip(ents[i])) continue;
+        tower_entity_think(entityManager, ents[i]);
+    }
+}
+
+void tower_update_batch(const entity_manager_t *entityManager, entity_t **ents, const uint32_t count, const float deltaTime) {
+    uint32_t i;
+    for (i = 0; i < count; i++) {
+        if (entity_batch_skip(ents[i])) continue;
+        tower_entity_update(entityManager, ents[i], deltaTime);
     }
 }
 
@@ -823,7 +928,7 @@ void tower_entity_destroy(const entity_manager_t *entityManager, entity_t *ent)
             server_broadcast_packet(&g_server, &statePkt, NET_UDP_FLAG_RELIABLE);
         }
 
-        s2c_tower_snapshot_packet_t *towerPkt = gfc_allocate_array(sizeof(s2c_tower_snapshot_packet_t), 1);
+        s2c_tower_snapshot_packet_t *towerPkt = buf_tick_alloc(sizeof(s2c_tower_snapshot_packet_t));
         tower_snapshot_data_t towerData = {0};
         create_s2c_tower_snapshot(towerPkt, tower->id, TOWER_SNAPSHOT_DESTROY, &towerData);
         server_broadcast_packet_batch(&g_server, towerPkt);
@@ -843,4 +948,16 @@ void tower_entity_destroy(const entity_manager_t *entityManager, entity_t *ent)
     }
     world_remove_entity(g_game.world, ent);
     ent->data = NULL; // Clear data pointer to avoid dangling reference
-}
\ No newline at end of file
+}
+
+void tower_register_entity_type(void) {
+    static const entity_type_ops_t ops = {
+        .thinkBatch = tower_think_batch,
+        .updateBatch = tower_update_batch,
+        .draw = tower_entity_draw,
+        .destroy = tower_entity_destroy,
+        .collidesWith = tower_collides_with,
+        .wake = tower_entity_wake
+    };
+    entity_register_type(ENTITY_TYPE_TOWER, &ops);
+}
@@ -7,6 +7,18 @@
 #include "common/game/world/tile.h"
 #include "common/game/world/world.h"
 
+#if CHUNK_TILE_SIZE > 16
+#error "Tile flag rows are 16 bit"
+#endif
+
+// Plane of a single TILE_FLAG, -1 for anything else
+static int chunk_tile_flag_plane(const uint32_t flag) {
+    if (!flag || (flag & (flag - 1)) || flag >= 1u << TILE_FLAG_COUNT) {
+        return -1;
+    }
+    return __builtin_ctz(flag);
+}
+
 chunk_t * chunk_create(const int x, const int y) {
     chunk_t *chunk = gfc_allocate_array(sizeof(chunk_t), 1);
     if (!chunk) {
@@ -22,10 +34,7 @@ void chunk_destroy(chunk_t *chunk) {
         return;
     }
 
-    if (chunk->entities) {
-        gfc_list_clear(chunk->entities);
-        free(chunk->entities);
-    }
+    layer_buckets_free(&chunk->entities);
 
     free(chunk);
 }
@@ -41,12 +50,6 @@ void chunk_initialize(chunk_t *chunk, const int x, const int y, void *data) {
     chunk->x = x;
     chunk->y = y;
 
-    if (!chunk->entities) {
-        chunk->entities = gfc_list_new();
-    } else {
-        gfc_list_clear(chunk->entities);
-    }
-
     if (data) {
         uint32_t *tileMap = (uint32_t*)data;
         for (i = 0; i < CHUNK_TILE_SIZE; i++) {
@@ -77,28 +80,71 @@ chunk_t * chunk_get(world_t *world, const int x, const int y) {
     return &world->chunks[x * world->size.y + y];
 }
 
-int chunk_has_entity(const chunk_t *chunk, const void *entity) {
+void chunk_refresh_tile(chunk_t *chunk, const int x, const int y) {
+    const tile_t *tile;
+    uint32_t flags;
+    int plane;
+    if (!chunk || x < 0 || y < 0 || x >= CHUNK_TILE_SIZE || y >= CHUNK_TILE_SIZE) {
+        return;
+    }
+
+    tile = tile_manager_get(g_game.tileManager, chunk->tiles[y][x]);
+    flags = tile ? tile->flags : 0;
+    for (plane = 0; plane < TILE_FLAG_COUNT; plane++) {
+        if (flags & (1u << plane)) {
+            chunk->tileFlags[plane][y] |= (uint16_t) (1u << x);
+        } else {
+            chunk->tileFlags[plane][y] &= (uint16_t) ~(1u << x);
+        }
+    }
+}
+
+int chunk_test_tile_flag(const chunk_t *chunk, const int x, const int y, const uint32_t flag) {
+    const int plane = chunk_tile_flag_plane(flag);
+    if (!chunk || plane < 0 || x < 0 || y < 0 || x >= CHUNK_TILE_SIZE || y >= CHUNK_TILE_SIZE) {
+        return 0;
+    }
+
+    return (chunk->tileFlags[plane][y] >> x) & 1;
+}
+
+uint16_t chunk_tile_flag_row(const chunk_t *chunk, const int y, const uint32_t flag) {
+    const int plane = chunk_tile_flag_plane(flag);
+    if (!chunk || plane < 0 || y < 0 || y >= CHUNK_TILE_SIZE) {
+        return 0;
+    }
+
+    return chunk->tileFlags[plane][y];
+}
+
+int chunk_has_entity(const chunk_t *chunk, const entity_t *entity) {
     if (!chunk || !entity) {
         return -1;
     }
 
-    return gfc_list_get_item_index(chunk->entities, (void*)entity);
+    return layer_buckets_contains(&chunk->entities, entity) ? (int) entity->_bucketIndex : -1;
 }
 
-void chunk_add_entity(chunk_t *chunk, void *entity) {
+void chunk_add_entity(chunk_t *chunk, entity_t *entity) {
     if (!chunk || !entity) {
         return;
     }
 
-    gfc_list_append(chunk->entities, entity);
+    if (chunk_has_entity(chunk, entity) >= 0) {
+        return; // Already listed
+    }
+
+    if (!layer_buckets_insert(&chunk->entities, entity)) {
+        log_error("Failed to add entity to chunk (%d, %d)", chunk->x, chunk->y);
+    }
 }
 
-void chunk_remove_entity(chunk_t *chunk, const void *entity) {
+void chunk_remove_entity(chunk_t *chunk, const entity_t *entity) {
     if (!chunk || !entity) {
         return;
     }
 
-    gfc_list_delete_data(chunk->entities, (void*)entity);
+    layer_buckets_remove(&chunk->entities, entity);
 }
 
 SDL_Texture * chunk_create_texture(const chunk_t *chunk, SDL_Renderer *renderer) {
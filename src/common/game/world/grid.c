@@ -0,0 +1,139 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/game/world/grid.h"
+
+#include "common/logger.h"
+#include "common/game/entity.h"
+
+static int grid_coord(const float pos, const float invCellSize, const int size) {
+    int coord = (int) floorf(pos * invCellSize);
+    if (coord < 0) return 0;
+    if (coord >= size) return size - 1;
+    return coord;
+}
+
+static uint32_t grid_cell_index(const grid_t *grid, const GFC_Vector2D pos) {
+    return (uint32_t) (grid_coord(pos.y, grid->invCellSize, grid->height) * grid->width +
+        grid_coord(pos.x, grid->invCellSize, grid->width));
+}
+
+int grid_init(grid_t *grid, const float worldWidth, const float worldHeight, const float cellSize) {
+    if (!grid || cellSize <= 0.0f) {
+        return 0;
+    }
+
+    memset(grid, 0, sizeof(grid_t));
+    grid->width = (int) ceilf(worldWidth / cellSize);
+    grid->height = (int) ceilf(worldHeight / cellSize);
+    if (grid->width < 1) grid->width = 1;
+    if (grid->height < 1) grid->height = 1;
+    grid->cellSize = cellSize;
+    grid->invCellSize = 1.0f / cellSize;
+
+    grid->cells = calloc((size_t) grid->width * grid->height, sizeof(grid_cell_t));
+    if (!grid->cells) {
+        log_error("Failed to allocate %dx%d grid cells", grid->width, grid->height);
+        return 0;
+    }
+
+    return 1;
+}
+
+void grid_destroy(grid_t *grid) {
+    int i;
+    if (!grid || !grid->cells) {
+        return;
+    }
+
+    for (i = 0; i < grid->width * grid->height; i++) {
+        layer_buckets_free(&grid->cells[i]);
+    }
+    free(grid->cells);
+    memset(grid, 0, sizeof(grid_t));
+}
+
+int grid_insert(grid_t *grid, entity_t *ent) {
+    uint32_t cell;
+    float extent;
+    if (!grid || !grid->cells || !ent) {
+        return 0;
+    }
+
+    if (grid_contains(ent)) {
+        grid_remove(grid, ent);
+    }
+
+    cell = grid_cell_index(grid, ent->position);
+    if (!layer_buckets_insert(&grid->cells[cell], ent)) {
+        return 0;
+    }
+    ent->_gridCell = cell + 1;
+
+    extent = fmaxf(fmaxf(fabsf(ent->boundingBox.x), fabsf(ent->boundingBox.x + ent->boundingBox.w)),
+        fmaxf(fabsf(ent->boundingBox.y), fabsf(ent->boundingBox.y + ent->boundingBox.h)));
+    if (extent > grid->margin) {
+        grid->margin = extent;
+    }
+
+    return 1;
+}
+
+void grid_move(grid_t *grid, entity_t *ent, const GFC_Vector2D newPos) {
+    uint32_t oldCell, newCell;
+    if (!grid || !grid->cells || !ent || !grid_contains(ent)) {
+        return;
+    }
+
+    oldCell = ent->_gridCell - 1;
+    newCell = grid_cell_index(grid, newPos);
+    if (newCell == oldCell) {
+        return;
+    }
+
+    layer_buckets_remove(&grid->cells[oldCell], ent);
+    if (!layer_buckets_insert(&grid->cells[newCell], ent)) {
+        ent->_gridCell = 0;
+        return;
+    }
+    ent->_gridCell = newCell + 1;
+}
+
+void grid_remove(grid_t *grid, entity_t *ent) {
+    if (!grid || !grid->cells || !ent || !grid_contains(ent)) {
+        return;
+    }
+
+    layer_buckets_remove(&grid->cells[ent->_gridCell - 1], ent);
+    ent->_gridCell = 0;
+}
+
+int grid_contains(const entity_t *ent) {
+    return ent && ent->_gridCell != 0;
+}
+
+int grid_cell_range(const grid_t *grid, const float minX, const float minY, const float maxX, const float maxY,
+    int *x0, int *y0, int *x1, int *y1) {
+    if (!grid || !grid->cells || !x0 || !y0 || !x1 || !y1) {
+        return 0;
+    }
+    if (maxX + grid->margin < 0.0f || maxY + grid->margin < 0.0f ||
+        minX - grid->margin >= grid->width * grid->cellSize || minY - grid->margin >= grid->height * grid->cellSize) {
+        return 0; // Entirely outside the grid
+    }
+
+    *x0 = grid_coord(minX - grid->margin, grid->invCellSize, grid->width);
+    *y0 = grid_coord(minY - grid->margin, grid->invCellSize, grid->height);
+    *x1 = grid_coord(maxX + grid->margin, grid->invCellSize, grid->width);
+    *y1 = grid_coord(maxY + grid->margin, grid->invCellSize, grid->height);
+    return 1;
+}
+
+const grid_cell_t *grid_get_cell(const grid_t *grid, const int x, const int y) {
+    if (!grid || !grid->cells || x < 0 || y < 0 || x >= grid->width || y >= grid->height) {
+        return NULL;
+    }
+
+    return &grid->cells[y * grid->width + x];
+}
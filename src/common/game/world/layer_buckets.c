@@ -0,0 +1,138 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/game/world/layer_buckets.h"
+
+#include "common/logger.h"
+#include "common/game/entity.h"
+#include "common/game/game.h"
+
+#if ENT_LAYER_RESOURCE != (1 << (LAYER_BUCKET_MIXED - 1))
+#error "Every ENT_LAYER bit needs its own bucket"
+#endif
+
+static uint32_t layer_bucket_of(const uint16_t layers) {
+    uint32_t bucket;
+
+    for (bucket = 0; bucket < LAYER_BUCKET_MIXED; bucket++) {
+        if (layers == 1u << bucket) return bucket;
+    }
+    return LAYER_BUCKET_MIXED;
+}
+
+static void layer_buckets_place(layer_buckets_t *buckets, const uint32_t index, const uint32_t slot) {
+    entity_t *ent;
+
+    buckets->slots[index] = slot;
+    ent = entity_from_slot(g_game.entityManager, slot);
+    if (ent) ent->_bucketIndex = index;
+}
+
+uint32_t layer_buckets_mask(const uint32_t layerMask) {
+    if (!layerMask) {
+        return LAYER_BUCKET_ALL;
+    }
+
+    return (layerMask & ((1u << LAYER_BUCKET_MIXED) - 1)) | (1u << LAYER_BUCKET_MIXED);
+}
+
+void layer_buckets_free(layer_buckets_t *buckets) {
+    if (!buckets) {
+        return;
+    }
+
+    free(buckets->slots);
+    memset(buckets, 0, sizeof(layer_buckets_t));
+}
+
+int layer_buckets_contains(const layer_buckets_t *buckets, const entity_t *ent) {
+    // The stored index may belong to another container, it only counts if this one's entry points back
+    return buckets && ent && ent->_bucketIndex < buckets->count && buckets->slots[ent->_bucketIndex] == ent->_slot;
+}
+
+int layer_buckets_insert(layer_buckets_t *buckets, entity_t *ent) {
+    uint32_t *newSlots, newCapacity, bucket, hole, k;
+    if (!buckets || !ent) {
+        return 0;
+    }
+
+    if (buckets->count >= buckets->capacity) {
+        newCapacity = buckets->capacity ? buckets->capacity * 2 : LAYER_BUCKETS_INITIAL_CAPACITY;
+        newSlots = realloc(buckets->slots, sizeof(uint32_t) * newCapacity);
+        if (!newSlots) {
+            log_error("Failed to grow layer buckets");
+            return 0;
+        }
+        buckets->slots = newSlots;
+        buckets->capacity = newCapacity;
+    }
+
+    // Open a hole at the end of the entity's bucket by moving the first entry of every later bucket to its end
+    bucket = layer_bucket_of(ent->layers);
+    hole = buckets->count;
+    for (k = LAYER_BUCKET_COUNT - 1; k > bucket; k--) {
+        if (buckets->ends[k - 1] != hole) {
+            layer_buckets_place(buckets, hole, buckets->slots[buckets->ends[k - 1]]);
+            hole = buckets->ends[k - 1];
+        }
+        buckets->ends[k]++;
+    }
+
+    buckets->slots[hole] = ent->_slot;
+    ent->_bucketIndex = hole;
+    buckets->ends[bucket]++;
+    buckets->count++;
+    return 1;
+}
+
+void layer_buckets_remove(layer_buckets_t *buckets, const entity_t *ent) {
+    uint32_t bucket, hole, last;
+    if (!layer_buckets_contains(buckets, ent)) {
+        return;
+    }
+
+    hole = ent->_bucketIndex;
+    for (bucket = 0; hole >= buckets->ends[bucket]; bucket++) {}
+
+    // Fill the hole with the last entry of its bucket, which leaves a hole at the bucket's end for the next one
+    for (; bucket < LAYER_BUCKET_COUNT; bucket++) {
+        last = buckets->ends[bucket] - 1;
+        if (last != hole) {
+            layer_buckets_place(buckets, hole, buckets->slots[last]);
+            hole = last;
+        }
+        buckets->ends[bucket]--;
+    }
+    buckets->count--;
+}
+
+int layer_buckets_next_span(const layer_buckets_t *buckets, const uint32_t bucketMask, uint32_t *bucket,
+    const uint32_t **slots, uint32_t *count) {
+    uint32_t b, start, end;
+    if (!buckets || !bucket || !slots || !count) {
+        return 0;
+    }
+
+    b = *bucket;
+    while (b < LAYER_BUCKET_COUNT) {
+        if (!(bucketMask & (1u << b))) {
+            b++;
+            continue;
+        }
+
+        start = b ? buckets->ends[b - 1] : 0;
+        while (b < LAYER_BUCKET_COUNT && (bucketMask & (1u << b))) {
+            b++;
+        }
+        end = buckets->ends[b - 1];
+        if (end > start) {
+            *bucket = b;
+            *slots = buckets->slots + start;
+            *count = end - start;
+            return 1;
+        }
+    }
+
+    *bucket = b;
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/game/world/occupancy.h"
+
+#include "common/logger.h"
+
+#define OCCUPANCY_SOLID_PLANE 0 // Index of the OCCUPANCY_SOLID bitmap
+
+// Index of an OCCUPANCY flag's bitmap
+static int occupancy_plane_index(const uint32_t plane) {
+    int i;
+
+    for (i = 0; i < OCCUPANCY_PLANE_COUNT; i++) {
+        if (plane == 1u << i) return i;
+    }
+    return -1;
+}
+
+// Bits x0..x1 of a word, both within it
+static uint64_t occupancy_word_mask(const int x0, const int x1) {
+    const uint64_t high = x1 >= 63 ? UINT64_MAX : (1ull << (x1 + 1)) - 1;
+    return high & ~((1ull << x0) - 1);
+}
+
+static int occupancy_clamp_area(const occupancy_t *occupancy, int *x0, int *y0, int *x1, int *y1) {
+    if (*x0 < 0) *x0 = 0;
+    if (*y0 < 0) *y0 = 0;
+    if (*x1 >= occupancy->width) *x1 = occupancy->width - 1;
+    if (*y1 >= occupancy->height) *y1 = occupancy->height - 1;
+    return *x0 <= *x1 && *y0 <= *y1;
+}
+
+int occupancy_init(occupancy_t *occupancy, const int width, const int height) {
+    int i;
+    if (!occupancy || width <= 0 || height <= 0) {
+        return 0;
+    }
+
+    memset(occupancy, 0, sizeof(occupancy_t));
+    occupancy->width = width;
+    occupancy->height = height;
+    occupancy->wordsPerRow = (uint32_t) (width + 63) / 64;
+
+    for (i = 0; i < OCCUPANCY_PLANE_COUNT; i++) {
+        occupancy->planes[i] = calloc((size_t) occupancy->wordsPerRow * height, sizeof(uint64_t));
+        if (!occupancy->planes[i]) {
+            log_error("Failed to allocate %dx%d occupancy plane", width, height);
+            occupancy_destroy(occupancy);
+            return 0;
+        }
+    }
+
+    occupancy->solidCounts = calloc((size_t) width * height, sizeof(uint8_t));
+    if (!occupancy->solidCounts) {
+        log_error("Failed to allocate %dx%d occupancy counts", width, height);
+        occupancy_destroy(occupancy);
+        return 0;
+    }
+
+    return 1;
+}
+
+void occupancy_destroy(occupancy_t *occupancy) {
+    int i;
+    if (!occupancy) {
+        return;
+    }
+
+    for (i = 0; i < OCCUPANCY_PLANE_COUNT; i++) {
+        free(occupancy->planes[i]);
+    }
+    free(occupancy->solidCounts);
+    memset(occupancy, 0, sizeof(occupancy_t));
+}
+
+void occupancy_set_tile(occupancy_t *occupancy, const uint32_t plane, const int x, const int y, const int blocked) {
+    const int index = occupancy_plane_index(plane);
+    uint64_t *word;
+    if (!occupancy || index < 0 || !occupancy->planes[index] || x < 0 || y < 0 || x >= occupancy->width || y >= occupancy->height) {
+        return;
+    }
+
+    word = &occupancy->planes[index][y * occupancy->wordsPerRow + x / 64];
+    if (blocked) {
+        *word |= 1ull << (x % 64);
+    } else {
+        *word &= ~(1ull << (x % 64));
+    }
+}
+
+void occupancy_add_solid(occupancy_t *occupancy, int x0, int y0, int x1, int y1) {
+    int x, y;
+    uint8_t *count;
+    if (!occupancy || !occupancy->solidCounts || !occupancy_clamp_area(occupancy, &x0, &y0, &x1, &y1)) {
+        return;
+    }
+
+    for (y = y0; y <= y1; y++) {
+        for (x = x0; x <= x1; x++) {
+            count = &occupancy->solidCounts[y * occupancy->width + x];
+            if (*count == UINT8_MAX) {
+                log_error("Too many blockers over tile (%d, %d)", x, y);
+                continue;
+            }
+            if ((*count)++ == 0) {
+                occupancy->planes[OCCUPANCY_SOLID_PLANE][y * occupancy->wordsPerRow + x / 64] |= 1ull << (x % 64);
+            }
+        }
+    }
+}
+
+void occupancy_remove_solid(occupancy_t *occupancy, int x0, int y0, int x1, int y1) {
+    int x, y;
+    uint8_t *count;
+    if (!occupancy || !occupancy->solidCounts || !occupancy_clamp_area(occupancy, &x0, &y0, &x1, &y1)) {
+        return;
+    }
+
+    for (y = y0; y <= y1; y++) {
+        for (x = x0; x <= x1; x++) {
+            count = &occupancy->solidCounts[y * occupancy->width + x];
+            if (*count == 0) {
+                continue; // Never added
+            }
+            if (--(*count) == 0) {
+                occupancy->planes[OCCUPANCY_SOLID_PLANE][y * occupancy->wordsPerRow + x / 64] &= ~(1ull << (x % 64));
+            }
+        }
+    }
+}
+
+int occupancy_test_area(const occupancy_t *occupancy, const uint32_t planes, int x0, int y0, int x1, int y1) {
+    const uint64_t *plane;
+    int i, y, word, firstWord, lastWord;
+    uint64_t mask;
+    if (!occupancy || !occupancy->solidCounts) {
+        return 1;
+    }
+    if (x0 < 0 || y0 < 0 || x1 >= occupancy->width || y1 >= occupancy->height) {
+        return 1; // Off the map
+    }
+    if (x0 > x1 || y0 > y1) {
+        return 0;
+    }
+
+    firstWord = x0 / 64;
+    lastWord = x1 / 64;
+    for (i = 0; i < OCCUPANCY_PLANE_COUNT; i++) {
+        if (!(planes & (1u << i))) continue;
+
+        plane = occupancy->planes[i];
+        for (y = y0; y <= y1; y++) {
+            for (word = firstWord; word <= lastWord; word++) {
+                mask = occupancy_word_mask(word == firstWord ? x0 % 64 : 0, word == lastWord ? x1 % 64 : 63);
+                if (plane[y * occupancy->wordsPerRow + word] & mask) {
+                    return 1;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
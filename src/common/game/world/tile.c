@@ -72,6 +72,13 @@ tile_manager_t * tile_manager_init(const char *file) {
             def_data_get_float(tileProperties, "damage_amount", &tile->properties.damageAmount);
         }
 
+        tile->flags = 0;
+        if (tile->properties.walkable) tile->flags |= TILE_FLAG_WALKABLE;
+        if (tile->properties.flyable) tile->flags |= TILE_FLAG_FLYABLE;
+        if (tile->properties.buildable) tile->flags |= TILE_FLAG_BUILDABLE;
+        if (tile->properties.harmful) tile->flags |= TILE_FLAG_HARMFUL;
+        if (tile->properties.modifySpeed) tile->flags |= TILE_FLAG_MODIFY_SPEED;
+
         tile->id = i;
         tile->sprite = tileSheetSprite;
         tile->spriteFrame = i;
@@ -105,8 +112,7 @@ int tile_test_flag(tile_manager_t *manager, const uint32_t id, const uint64_t fl
         return 0;
     }
 
-    (void)flag;
-    return 0;
+    return (tile->flags & flag) != 0;
 }
 
 void tile_draw_tile(tile_manager_t *manager, const uint32_t id, const int x, const int y) {
@@ -9,6 +9,7 @@
 #include "client/ui/overlay.h"
 #include "common/def.h"
 #include "common/logger.h"
+#include "common/buffer/arena.h"
 #include "common/game/enemy.h"
 #include "common/game/entity.h"
 #include "common/game/game.h"
@@ -22,6 +23,59 @@
 extern uint8_t __DEBUG_LINES;
 
 void world_load_entities(world_t *world, def_data_t *worldDef);
+
+// Tiles an area covers, edges that only touch a tile do not count
+static void world_area_tiles(const GFC_Rect area, int *x0, int *y0, int *x1, int *y1) {
+    *x0 = (int) floorf(area.x / TILE_SIZE);
+    *y0 = (int) floorf(area.y / TILE_SIZE);
+    *x1 = (int) ceilf((area.x + area.w) / TILE_SIZE) - 1;
+    *y1 = (int) ceilf((area.y + area.h) / TILE_SIZE) - 1;
+    if (*x1 < *x0) *x1 = *x0;
+    if (*y1 < *y0) *y1 = *y0;
+}
+
+// Static entities flagged solid block the tiles under their bounding box
+static void world_stamp_solid(world_t *world, const entity_t *ent, const GFC_Vector2D position, const int add) {
+    int x0, y0, x1, y1;
+    if (!(ent->flags & ENT_FLAG_COLLIDE_SOLID)) {
+        return;
+    }
+
+    world_area_tiles(gfc_rect(position.x + ent->boundingBox.x, position.y + ent->boundingBox.y,
+        ent->boundingBox.w, ent->boundingBox.h), &x0, &y0, &x1, &y1);
+    if (add) {
+        occupancy_add_solid(&world->occupancy, x0, y0, x1, y1);
+    } else {
+        occupancy_remove_solid(&world->occupancy, x0, y0, x1, y1);
+    }
+}
+
+// Also builds the chunks' tile flag planes, world_refresh_tile keeps both in step
+static int world_init_occupancy(world_t *world) {
+    int x, y;
+
+    if (!occupancy_init(&world->occupancy, world->size.x * CHUNK_TILE_SIZE, world->size.y * CHUNK_TILE_SIZE)) {
+        log_error("Failed to create the world occupancy map");
+        return 0;
+    }
+    for (y = 0; y < world->occupancy.height; y++) {
+        for (x = 0; x < world->occupancy.width; x++) {
+            world_refresh_tile(world, x, y);
+        }
+    }
+    return 1;
+}
+
+static int world_init_grid(world_t *world) {
+    const float worldWidth = (float) world->size.x * CHUNK_TILE_SIZE * TILE_SIZE;
+    const float worldHeight = (float) world->size.y * CHUNK_TILE_SIZE * TILE_SIZE;
+
+    if (!grid_init(&world->grid, worldWidth, worldHeight, WORLD_GRID_CELL_TILES * TILE_SIZE)) {
+        log_error("Failed to create the world grid");
+        return 0;
+    }
+    return 1;
+}
 void world_tower_options_draw(overlay_element_t *element);
 
 world_t * world_create_empty(int width, int height) {
@@ -33,6 +87,8 @@ world_t * world_create_empty(int width, int height) {
 
     world->size.x = width;
     world->size.y = height;
+    world->chunkMargin = 0.0f;
+    phys_init(&world->bodies);
     world->chunks = malloc(sizeof(chunk_t) * width * height);
     if (!world->chunks) {
         free(world);
@@ -45,6 +101,18 @@ world_t * world_create_empty(int width, int height) {
         }
     }
 
+    if (!world_init_grid(world)) {
+        free(world->chunks);
+        free(world);
+        return NULL;
+    }
+    if (!world_init_occupancy(world)) {
+        grid_destroy(&world->grid);
+        free(world->chunks);
+        free(world);
+        return NULL;
+    }
+
     return world;
 }
 
@@ -78,6 +146,8 @@ world_t *world_create_from_file(const char *file) {
 
     world->size.x = header.height;
     world->size.y = header.width;
+    world->chunkMargin = 0.0f;
+    phys_init(&world->bodies);
     world->chunks = gfc_allocate_array(sizeof(chunk_t), header.numChunks);
 
     chunkData = malloc(sizeof(uint32_t) * CHUNK_TILE_SIZE * CHUNK_TILE_SIZE * header.numChunks);
@@ -97,6 +167,14 @@ world_t *world_create_from_file(const char *file) {
         }
     }
 
+    if (!world_init_grid(world)) {
+        goto error;
+    }
+    if (!world_init_occupancy(world)) {
+        grid_destroy(&world->grid);
+        goto error;
+    }
+
     free(chunkData);
     return world;
 
@@ -226,6 +304,9 @@ void world_destroy(world_t *world) {
             chunk_destroy(&world->chunks[i * world->size.y + j]);
         }
     }
+    grid_destroy(&world->grid);
+    occupancy_destroy(&world->occupancy);
+    phys_free(&world->bodies);
 }
 
 chunk_t * world_get_chunk(const world_t *world, const int x, const int y) {
@@ -311,11 +392,12 @@ void world_spawn_wave(world_t *world) {
         spawnPos = random_point_in_radius(pos, minSpawnRadius, maxSpawnRadius);
 
         entity = enemy_spawn(g_game.entityManager, wave->enemies[i], spawnPos);
-        if (entity && entity->data) {
+        if (!entity) continue;
+        if (entity->data) {
             ((enemy_state_t *)entity->data)->targetTeamID = TEAM_NONE;
         }
 
-        pkt = gfc_allocate_array(sizeof(s2c_enemy_snapshot_packet_t), 1);
+        pkt = buf_tick_alloc(sizeof(s2c_enemy_snapshot_packet_t));
         enemy_snapshot_data_t eventData = {
             .spawnData = {
                 .enemyDefIndex = wave->enemies[i]->index,
@@ -363,11 +445,23 @@ void world_update(world_t *world, float deltaTime) {
 
 int world_on_click(world_t *world, uint32_t mouseButton, int x, int y) {
     GFC_Vector2D worldPos;
+    entity_t *selectedEnt = NULL;
     int i;
     if (!world) {
         return 0;
     }
 
+    if (world->selected_tower) {
+        selectedEnt = entity_resolve(g_game.entityManager, world->selected_tower->tower);
+        if (!selectedEnt) {
+            // Sold or destroyed while selected
+            world->selected_tower->element->destroy(world->selected_tower->element);
+            free(world->selected_tower->element);
+            free(world->selected_tower);
+            world->selected_tower = NULL;
+        }
+    }
+
     // Convert screen coordinates to world coordinates
     camera_get_mouse_world_position(&g_camera, &worldPos);
 
@@ -375,7 +469,7 @@ int world_on_click(world_t *world, uint32_t mouseButton, int x, int y) {
     if (world->selected_tower && (mouseButton & SDL_BUTTON(SDL_BUTTON_LEFT))) {
         // Check if click is outside the tower options overlay
         overlay_element_t *element = world->selected_tower->element;
-        tower_state_t *selectedTower = (tower_state_t *)world->selected_tower->tower->data;
+        tower_state_t *selectedTower = (tower_state_t *)selectedEnt->data;
         GFC_Rect buttonRect;
         int pressed = 0;
 
@@ -395,7 +489,7 @@ int world_on_click(world_t *world, uint32_t mouseButton, int x, int y) {
                 if (!gfc_point_in_rect(worldPos, gridRect)) {
                     continue;
                 }
-                tower_request_set_production_enemy(world->selected_tower->tower, enemyDefs[enemyIndex].index);
+                tower_request_set_production_enemy(selectedEnt, enemyDefs[enemyIndex].index);
                 pressed = 1;
                 break;
             }
@@ -408,7 +502,7 @@ int world_on_click(world_t *world, uint32_t mouseButton, int x, int y) {
             30
         );
         if (!pressed && gfc_point_in_rect(worldPos, buttonRect)) {
-            tower_request_upgrade(g_game.entityManager, g_game.towerManager, world->selected_tower->tower);
+            tower_request_upgrade(g_game.entityManager, g_game.towerManager, selectedEnt);
             pressed = 1;
         }
         if (!pressed) {
@@ -416,7 +510,7 @@ int world_on_click(world_t *world, uint32_t mouseButton, int x, int y) {
             if (gfc_point_in_rect(worldPos, buttonRect)) {
                 c2s_tower_request_packet_t pkt;
                 tower_request_data_t data;
-                tower_state_t *towerState = (tower_state_t *)world->selected_tower->tower->data;
+                tower_state_t *towerState = (tower_state_t *)selectedEnt->data;
                 if (towerState) {
                     data.sellData.towerID = towerState->id;
                     create_c2s_tower_request(&pkt, TOWER_REQUEST_SELL, &data);
@@ -438,8 +532,8 @@ int world_on_click(world_t *world, uint32_t mouseButton, int x, int y) {
     chunk_t *chunk = world_get_chunk(world, pos_to_chunk_coord(worldPos.x), pos_to_chunk_coord(worldPos.y));
     if (chunk) {
         // Check if an entity was clicked
-        for (i = 0; i < gfc_list_count(chunk->entities); i++) {
-            entity_t *ent = gfc_list_get_nth(chunk->entities, i);
+        for (i = 0; i < chunk->entities.count; i++) {
+            entity_t *ent = entity_from_slot(g_game.entityManager, chunk->entities.slots[i]);
             GFC_Rect rect = gfc_rect(
                 ent->position.x + ent->boundingBox.x,
                 ent->position.y + ent->boundingBox.y,
@@ -461,7 +555,7 @@ int world_on_click(world_t *world, uint32_t mouseButton, int x, int y) {
             }
 
             if (world->selected_tower) {
-                if (world->selected_tower->tower != ent) {
+                if (world->selected_tower->tower != entity_get_handle(g_game.entityManager, ent)) {
                     world->selected_tower->element->destroy(world->selected_tower->element);
                     free(world->selected_tower->element);
                     free(world->selected_tower);
@@ -479,7 +573,7 @@ int world_on_click(world_t *world, uint32_t mouseButton, int x, int y) {
                     continue;
                 }
                 selected_tower_t *selected = malloc(sizeof(selected_tower_t));
-                selected->tower = ent;
+                selected->tower = entity_get_handle(g_game.entityManager, ent);
                 selected->upgradeLevel = towerState->level;
                 selected->element = overlay_create_simple_element(
                     TYPE_TOWER_OPTIONS,
@@ -497,8 +591,76 @@ int world_on_click(world_t *world, uint32_t mouseButton, int x, int y) {
     }
 }
 
+void world_refresh_tile(world_t *world, const int tileX, const int tileY) {
+    chunk_t *chunk;
+    const int localX = tileX % CHUNK_TILE_SIZE, localY = tileY % CHUNK_TILE_SIZE;
+    if (!world || tileX < 0 || tileY < 0) {
+        return;
+    }
+
+    chunk = world_get_chunk(world, tileX / CHUNK_TILE_SIZE, tileY / CHUNK_TILE_SIZE);
+    if (!chunk) {
+        return;
+    }
+
+    chunk_refresh_tile(chunk, localX, localY);
+    occupancy_set_tile(&world->occupancy, OCCUPANCY_NO_WALK, tileX, tileY,
+        !chunk_test_tile_flag(chunk, localX, localY, TILE_FLAG_WALKABLE));
+    occupancy_set_tile(&world->occupancy, OCCUPANCY_NO_FLY, tileX, tileY,
+        !chunk_test_tile_flag(chunk, localX, localY, TILE_FLAG_FLYABLE));
+}
+
+int world_test_tile_flag(const world_t *world, const GFC_Vector2D worldPos, const uint32_t flag) {
+    const int tileX = (int) floorf(worldPos.x / TILE_SIZE), tileY = (int) floorf(worldPos.y / TILE_SIZE);
+    if (!world || tileX < 0 || tileY < 0) {
+        return 0;
+    }
+
+    return chunk_test_tile_flag(world_get_chunk(world, tileX / CHUNK_TILE_SIZE, tileY / CHUNK_TILE_SIZE),
+        tileX % CHUNK_TILE_SIZE, tileY % CHUNK_TILE_SIZE, flag);
+}
+
+int world_tiles_have_flag(const world_t *world, const int x0, const int y0, const int x1, const int y1, const uint32_t flag) {
+    const chunk_t *chunk;
+    int x, y, spanEnd;
+    uint16_t need;
+    if (!world || x0 < 0 || y0 < 0 || x1 < x0 || y1 < y0) {
+        return 0;
+    }
+
+    // A row is split at chunk edges, each piece is one masked compare against the chunk's plane row
+    for (y = y0; y <= y1; y++) {
+        for (x = x0; x <= x1; x = spanEnd + 1) {
+            chunk = world_get_chunk(world, x / CHUNK_TILE_SIZE, y / CHUNK_TILE_SIZE);
+            if (!chunk) {
+                return 0;
+            }
+
+            spanEnd = (x / CHUNK_TILE_SIZE + 1) * CHUNK_TILE_SIZE - 1;
+            if (spanEnd > x1) spanEnd = x1;
+            need = (uint16_t) (((1u << (spanEnd % CHUNK_TILE_SIZE + 1)) - 1) & ~((1u << (x % CHUNK_TILE_SIZE)) - 1));
+            if ((chunk_tile_flag_row(chunk, y % CHUNK_TILE_SIZE, flag) & need) != need) {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+int world_area_blocked(const world_t *world, const GFC_Rect area, const uint32_t planes) {
+    int x0, y0, x1, y1;
+    if (!world) {
+        return 1;
+    }
+
+    world_area_tiles(area, &x0, &y0, &x1, &y1);
+    return occupancy_test_area(&world->occupancy, planes, x0, y0, x1, y1);
+}
+
 void world_clear(world_t *world) {
     chunk_t *chunk;
+    const grid_cell_t *cell;
     entity_t *ent;
     int i, j, k;
     if (!world) {
@@ -507,16 +669,26 @@ void world_clear(world_t *world) {
     for (i = 0; i < world->size.x; i++) {
         for (j = 0; j < world->size.y; j++) {
             chunk = &world->chunks[i * world->size.y + j];
-            for (k = 0; k < gfc_list_count(chunk->entities); k++) {
-                ent = gfc_list_get_nth(chunk->entities, k);
+            for (k = 0; k < chunk->entities.count; k++) {
+                ent = entity_from_slot(g_game.entityManager, chunk->entities.slots[k]);
                 if (ent && (ent->layers & (ENT_LAYER_TOWER | ENT_LAYER_PROJECTILE | ENT_LAYER_ENEMY))) {
-                    ent->think = entity_free;
+                    entity_queue_destroy(g_game.entityManager, ent);
                 }
             }
 
 
         }
     }
+
+    for (i = 0; i < world->grid.width * world->grid.height; i++) {
+        cell = &world->grid.cells[i];
+        for (k = 0; k < cell->count; k++) {
+            ent = entity_from_slot(g_game.entityManager, cell->slots[k]);
+            if (ent && (ent->layers & (ENT_LAYER_PROJECTILE | ENT_LAYER_ENEMY))) {
+                entity_queue_destroy(g_game.entityManager, ent);
+            }
+        }
+    }
 }
 
 void world_draw(const world_t *world) {
@@ -581,6 +753,7 @@ void world_draw(const world_t *world) {
 }
 
 int world_add_entity(world_t *world, entity_t *ent) {
+    float extent;
     if (!world || !ent) {
         return 0;
     }
@@ -589,7 +762,17 @@ int world_add_entity(world_t *world, entity_t *ent) {
     int chunkY = pos_to_chunk_coord(ent->position.y);
 
     if (chunkX >= 0 && chunkX < world->size.x && chunkY >= 0 && chunkY < world->size.y) {
+        if (ent->layers & WORLD_DYNAMIC_LAYERS) {
+            return grid_insert(&world->grid, ent);
+        }
         chunk_add_entity(&world->chunks[chunkX * world->size.y + chunkY], ent);
+        world_stamp_solid(world, ent, ent->position, 1);
+
+        extent = fmaxf(fmaxf(fabsf(ent->boundingBox.x), fabsf(ent->boundingBox.x + ent->boundingBox.w)),
+            fmaxf(fabsf(ent->boundingBox.y), fabsf(ent->boundingBox.y + ent->boundingBox.h)));
+        if (extent > world->chunkMargin) {
+            world->chunkMargin = extent;
+        }
         return 1;
     }
 
@@ -597,6 +780,8 @@ int world_add_entity(world_t *world, entity_t *ent) {
 }
 
 int world_move_entity(world_t *world, entity_t *ent, const GFC_Vector2D newPos) {
+    chunk_t *oldChunk;
+    int listed;
     if (!world || !ent) {
         return 0;
     }
@@ -606,18 +791,31 @@ int world_move_entity(world_t *world, entity_t *ent, const GFC_Vector2D newPos)
     int newChunkX = pos_to_chunk_coord(newPos.x);
     int newChunkY = pos_to_chunk_coord(newPos.y);
 
-    if (newChunkX != oldChunkX || newChunkY != oldChunkY) {
-        if (newChunkX >= 0 && newChunkX < world->size.x && newChunkY >= 0 && newChunkY < world->size.y) {
-            chunk_add_entity(&world->chunks[newChunkX * world->size.y + newChunkY], ent);
-        } else {
+    if (grid_contains(ent)) {
+        if (newChunkX < 0 || newChunkX >= world->size.x || newChunkY < 0 || newChunkY >= world->size.y) {
             return 0; // New position is out of world bounds
         }
+        grid_move(&world->grid, ent, newPos);
+        return 1;
+    }
+
+    oldChunk = world_get_chunk(world, oldChunkX, oldChunkY);
+    listed = oldChunk && chunk_has_entity(oldChunk, ent) >= 0;
 
-        if (oldChunkX >= 0 && oldChunkX < world->size.x && oldChunkY >= 0 && oldChunkY < world->size.y) {
-            chunk_remove_entity(&world->chunks[oldChunkX * world->size.y + oldChunkY], ent);
+    if (newChunkX != oldChunkX || newChunkY != oldChunkY) {
+        if (newChunkX < 0 || newChunkX >= world->size.x || newChunkY < 0 || newChunkY >= world->size.y) {
+            return 0; // New position is out of world bounds
         }
+
+        // Removed first, the entity only remembers its index in one chunk
+        chunk_remove_entity(oldChunk, ent);
+        chunk_add_entity(&world->chunks[newChunkX * world->size.y + newChunkY], ent);
     }
 
+    if (listed) {
+        world_stamp_solid(world, ent, ent->position, 0);
+    }
+    world_stamp_solid(world, ent, newPos, 1);
     return 1;
 }
 
@@ -626,10 +824,18 @@ int world_remove_entity(world_t *world, entity_t *ent) {
         return 0;
     }
 
+    if (grid_contains(ent)) {
+        grid_remove(&world->grid, ent);
+        return 1;
+    }
+
     int chunkX = pos_to_chunk_coord(ent->position.x);
     int chunkY = pos_to_chunk_coord(ent->position.y);
 
     if (chunkX >= 0 && chunkX < world->size.x && chunkY >= 0 && chunkY < world->size.y) {
+        if (chunk_has_entity(&world->chunks[chunkX * world->size.y + chunkY], ent) >= 0) {
+            world_stamp_solid(world, ent, ent->position, 0);
+        }
         chunk_remove_entity(&world->chunks[chunkX * world->size.y + chunkY], ent);
         return 1;
     }
@@ -664,6 +870,7 @@ struct entity_s * world_object_resource_spawn(world_t *world, GFC_Vector2D pos,
     ent->boundingBox = gfc_rect(0, 0, 144, 144); // Example bounding box, adjust as needed
     ent->layers = ENT_LAYER_RESOURCE;
     ent->data = resource; // Store item data in entity for later use
+    entity_sync_hot(g_game.entityManager, ent);
 
     if (image && strlen(image) > 0) {
         ent->model = gf2d_sprite_load_image(image);
@@ -682,7 +889,8 @@ void world_tower_options_draw(overlay_element_t *element) {
 
     gfc_vector2d_sub(pos, element->position, g_camera.position);
 
-    tower_state_t *state = (tower_state_t *)g_game.world->selected_tower->tower->data;
+    entity_t *tower = entity_resolve(g_game.entityManager, g_game.world->selected_tower->tower);
+    tower_state_t *state = tower ? (tower_state_t *)tower->data : NULL;
     if (!state || !state->def) {
         return;
     }
@@ -9,8 +9,6 @@
 
 #include "common/game/game.h"
 
-void network_handle_receive(network_t *network, const net_udp_event_t *context);
-
 int network_init(network_t *network, const network_settings_t *settings, void *networkAdapter) {
     if (!network) {
         return -1;
@@ -49,7 +47,11 @@ void network_tick(network_t *network) {
                 }
                 break;
             case NET_UDP_EVENT_TYPE_RECEIVE:
-                network_handle_receive(network, &event);
+                if (network->settings.onReceive) {
+                    network->settings.onReceive(network, &event);
+                } else {
+                    network_handle_receive(network, &event);
+                }
                 break;
             case NET_UDP_EVENT_TYPE_DISCONNECT:
                 if (network->settings.onDisconnect) {
@@ -62,6 +64,14 @@ void network_tick(network_t *network) {
     }
 }
 
+int network_wait(network_t *network, const uint32_t timeoutMs) {
+    if (!network || !network->running) {
+        return 0;
+    }
+
+    return net_udp_host_wait_events(network->udpHost, timeoutMs);
+}
+
 int network_send(net_udp_peer_t *peer, void *pkt, const uint32_t flags) {
     size_t numBytes, length;
     uint8_t *buffer;
@@ -126,23 +136,28 @@ int network_send_batch(net_udp_peer_t *peer, void **pkts, const uint32_t count)
 }
 
 void network_handle_receive(network_t *network, const net_udp_event_t *context) {
-    net_udp_packet_t *rawPacket;
-    net_udp_peer_t *peer;
+    if (!network || !context->packet || !context->peer) {
+        return;
+    }
+
+    network_dispatch_packet(network, context->packet, context->peer);
+}
+
+void network_dispatch_packet(network_t *network, net_udp_packet_t *rawPacket, void *handlerContext) {
     buffer_offset_t offset;
     uint8_t packetID;
     size_t length, bytes;
     buffer_t buffer;
 
-    if (!network || !context->packet || !context->peer) {
+    if (!network || !rawPacket) {
         return;
     }
 
-    rawPacket = context->packet;
-    peer = context->peer;
     bytes = rawPacket->dataLength;
     buffer = rawPacket->data;
-    if (!peer || !buffer || bytes == 0) {
+    if (!handlerContext || !buffer || bytes == 0) {
         log_debug("Received NULL or empty packet.");
+        net_udp_packet_destroy(rawPacket);
         return;
     }
 
@@ -160,7 +175,7 @@ void network_handle_receive(network_t *network, const net_udp_event_t *context)
             break;
         }
 
-        packet_dispatch_table[packetID](buffer, &offset, peer);
+        packet_dispatch_table[packetID](buffer, &offset, handlerContext);
     }
 
     net_udp_packet_destroy(rawPacket);
@@ -66,6 +66,18 @@ void receive_s2c_enemy_snapshot(buffer_t buf, buffer_offset_t *off, void *c) {
     handle_s2c_enemy_snapshot(&pkt, c);
 }
 
+void receive_s2c_enemy_despawn_batch(buffer_t buf, buffer_offset_t *off, void *c) {
+    s2c_enemy_despawn_batch_packet_t pkt;
+    read_s2c_enemy_despawn_batch(buf, off, &pkt);
+    handle_s2c_enemy_despawn_batch(&pkt, c);
+}
+
+void receive_s2c_enemy_damage_batch(buffer_t buf, buffer_offset_t *off, void *c) {
+    s2c_enemy_damage_batch_packet_t pkt;
+    read_s2c_enemy_damage_batch(buf, off, &pkt);
+    handle_s2c_enemy_damage_batch(&pkt, c);
+}
+
 packet_receive_fn packet_dispatch_table[PACKET_COUNT] = {
     [PACKET_C2S_PLAYER_JOIN_REQUEST] = receive_c2s_player_join_request,
     [PACKET_S2C_PLAYER_JOIN_RESPONSE] = receive_s2c_player_join_response,
@@ -78,6 +90,8 @@ packet_receive_fn packet_dispatch_table[PACKET_COUNT] = {
     [PACKET_S2C_INVENTORY_UPDATE] = receive_s2c_inventory_update,
     [PACKET_S2C_GAME_STATE_SNAPSHOT] = receive_s2c_game_state_snapshot,
     [PACKET_S2C_ENEMY_SNAPSHOT] = receive_s2c_enemy_snapshot,
+    [PACKET_S2C_ENEMY_DESPAWN_BATCH] = receive_s2c_enemy_despawn_batch,
+    [PACKET_S2C_ENEMY_DAMAGE_BATCH] = receive_s2c_enemy_damage_batch,
 };
 
 void prepare_send_c2s_player_join_request(buffer_t buf, buffer_offset_t *off, void *c) {
@@ -124,6 +138,14 @@ void prepare_send_s2c_enemy_snapshot(buffer_t buf, buffer_offset_t *off, void *c
     write_s2c_enemy_snapshot(buf, off, (s2c_enemy_snapshot_packet_t *) c);
 }
 
+void prepare_send_s2c_enemy_despawn_batch(buffer_t buf, buffer_offset_t *off, void *c) {
+    write_s2c_enemy_despawn_batch(buf, off, (s2c_enemy_despawn_batch_packet_t *) c);
+}
+
+void prepare_send_s2c_enemy_damage_batch(buffer_t buf, buffer_offset_t *off, void *c) {
+    write_s2c_enemy_damage_batch(buf, off, (s2c_enemy_damage_batch_packet_t *) c);
+}
+
 packet_send_fn packet_send_table[PACKET_COUNT] = {
     [PACKET_C2S_PLAYER_JOIN_REQUEST] = prepare_send_c2s_player_join_request,
     [PACKET_S2C_PLAYER_JOIN_RESPONSE] = prepare_send_s2c_player_join_response,
@@ -136,4 +158,6 @@ packet_send_fn packet_send_table[PACKET_COUNT] = {
     [PACKET_S2C_INVENTORY_UPDATE] = prepare_send_s2c_inventory_update,
     [PACKET_S2C_GAME_STATE_SNAPSHOT] = prepare_send_s2c_game_state_snapshot,
     [PACKET_S2C_ENEMY_SNAPSHOT] = prepare_send_s2c_enemy_snapshot,
+    [PACKET_S2C_ENEMY_DESPAWN_BATCH] = prepare_send_s2c_enemy_despawn_batch,
+    [PACKET_S2C_ENEMY_DAMAGE_BATCH] = prepare_send_s2c_enemy_damage_batch,
 };
@@ -278,6 +278,7 @@ void read_inventory_transaction(buffer_t buffer, buffer_offset_t *offset, invent
     transaction->items = read_item_array(buffer, offset, &numItems, MAX_ITEMS_LENGTH);
     transaction->numItems = numItems;
     transaction->capacity = transaction->numItems; // Set capacity to match the number of items read
+    transaction->transient = 0;
 }
 
 void write_c2s_player_join_request(buffer_t buf, buffer_offset_t *off,
@@ -427,6 +428,27 @@ void write_s2c_enemy_snapshot(buffer_t buf, buffer_offset_t *off, const s2c_enem
     }
 }
 
+void write_s2c_enemy_despawn_batch(buffer_t buf, buffer_offset_t *off, const s2c_enemy_despawn_batch_packet_t *pkt) {
+    uint16_t i;
+    write_uint8(buf, off, pkt->packetID);
+    write_uint64(buf, off, pkt->length);
+    write_uint16(buf, off, pkt->count);
+    for (i = 0; i < pkt->count; i++) {
+        write_int64(buf, off, pkt->enemyIDs[i]);
+    }
+}
+
+void write_s2c_enemy_damage_batch(buffer_t buf, buffer_offset_t *off, const s2c_enemy_damage_batch_packet_t *pkt) {
+    uint16_t i;
+    write_uint8(buf, off, pkt->packetID);
+    write_uint64(buf, off, pkt->length);
+    write_uint16(buf, off, pkt->count);
+    for (i = 0; i < pkt->count; i++) {
+        write_int64(buf, off, pkt->entries[i].enemyID);
+        write_float(buf, off, pkt->entries[i].health);
+    }
+}
+
 void read_c2s_player_join_request(buffer_t buf, buffer_offset_t *off, c2s_player_join_request_packet_t *pkt) {
     pkt->packetID = read_uint8(buf, off);
     pkt->length = read_uint64(buf, off);
@@ -572,6 +594,38 @@ void read_s2c_enemy_snapshot(buffer_t buf, buffer_offset_t *off, s2c_enemy_snaps
     }
 }
 
+void read_s2c_enemy_despawn_batch(buffer_t buf, buffer_offset_t *off, s2c_enemy_despawn_batch_packet_t *pkt) {
+    uint16_t i, count;
+    pkt->packetID = read_uint8(buf, off);
+    pkt->length = read_uint64(buf, off);
+    count = read_uint16(buf, off);
+    pkt->count = count > ENEMY_DESPAWN_BATCH_MAX ? ENEMY_DESPAWN_BATCH_MAX : count;
+    for (i = 0; i < count; i++) {
+        if (i < ENEMY_DESPAWN_BATCH_MAX) {
+            pkt->enemyIDs[i] = read_int64(buf, off);
+        } else {
+            read_int64(buf, off); // Skip IDs past the limit to keep the offset in sync
+        }
+    }
+}
+
+void read_s2c_enemy_damage_batch(buffer_t buf, buffer_offset_t *off, s2c_enemy_damage_batch_packet_t *pkt) {
+    uint16_t i, count;
+    pkt->packetID = read_uint8(buf, off);
+    pkt->length = read_uint64(buf, off);
+    count = read_uint16(buf, off);
+    pkt->count = count > ENEMY_DAMAGE_BATCH_MAX ? ENEMY_DAMAGE_BATCH_MAX : count;
+    for (i = 0; i < count; i++) {
+        if (i < ENEMY_DAMAGE_BATCH_MAX) {
+            pkt->entries[i].enemyID = read_int64(buf, off);
+            pkt->entries[i].health = read_float(buf, off);
+        } else {
+            read_int64(buf, off); // Skip entries past the limit to keep the offset in sync
+            read_float(buf, off);
+        }
+    }
+}
+
 void create_c2s_player_join_request(c2s_player_join_request_packet_t *pkt, char *name) {
     pkt->packetID = PACKET_C2S_PLAYER_JOIN_REQUEST;
     pkt->length = sizeof(uint16_t) + strnlen(name, MAX_STRING_LENGTH);
@@ -717,3 +771,21 @@ void create_s2c_enemy_snapshot(s2c_enemy_snapshot_packet_t *pkt, int64_t enemyID
     pkt->eventID = eventID;
     pkt->eventData = *eventData;
 }
+
+void create_s2c_enemy_despawn_batch(s2c_enemy_despawn_batch_packet_t *pkt, const int64_t *enemyIDs, uint16_t count) {
+    if (count > ENEMY_DESPAWN_BATCH_MAX) count = ENEMY_DESPAWN_BATCH_MAX;
+
+    pkt->packetID = PACKET_S2C_ENEMY_DESPAWN_BATCH;
+    pkt->length = sizeof(uint16_t) + sizeof(int64_t) * count;
+    pkt->count = count;
+    memcpy(pkt->enemyIDs, enemyIDs, sizeof(int64_t) * count);
+}
+
+void create_s2c_enemy_damage_batch(s2c_enemy_damage_batch_packet_t *pkt, const enemy_damage_entry_t *entries, uint16_t count) {
+    if (count > ENEMY_DAMAGE_BATCH_MAX) count = ENEMY_DAMAGE_BATCH_MAX;
+
+    pkt->packetID = PACKET_S2C_ENEMY_DAMAGE_BATCH;
+    pkt->length = sizeof(uint16_t) + (sizeof(int64_t) + sizeof(float)) * count;
+    pkt->count = count;
+    memcpy(pkt->entries, entries, sizeof(enemy_damage_entry_t) * count);
+}
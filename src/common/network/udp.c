@@ -190,6 +190,7 @@ net_udp_host_t *net_udp_host_create(const net_udp_host_config_t *config) {
     }
 
     mutex_init(&host->hostLock);
+    condvar_init(&host->eventCond);
     host->state = NET_HOST_IDLE;
     host->threadRunning = 1;
     host->shutdownStartTime = 0;
@@ -220,6 +221,7 @@ void net_udp_host_destroy(net_udp_host_t *host) {
 
     // Destroy
     enet_host_destroy(host->enetHost);
+    condvar_destroy(&host->eventCond);
     mutex_destroy(&host->hostLock);
     buf_spsc_ring_destroy(&host->eventBuffer);
 }
@@ -228,6 +230,22 @@ int net_udp_host_check_events(net_udp_host_t *host, net_udp_event_t *event) {
     return buf_spsc_ring_pop(&host->eventBuffer, event);
 }
 
+int net_udp_host_wait_events(net_udp_host_t *host, const uint32_t timeoutMs) {
+    int ready;
+    if (!host || !host->isServer) {
+        return 0;
+    }
+
+    mutex_lock(&host->hostLock);
+    if (buf_spsc_ring_is_empty(&host->eventBuffer) && host->threadRunning) {
+        condvar_timedWaitMs(&host->eventCond, &host->hostLock, timeoutMs);
+    }
+    ready = !buf_spsc_ring_is_empty(&host->eventBuffer);
+    mutex_unlock(&host->hostLock);
+
+    return ready;
+}
+
 int net_udp_service(const net_udp_host_t *host, net_udp_event_t *event, const uint32_t timeout) {
     struct _ENetEvent ev;
     int status = enet_host_service(host->enetHost, &ev, timeout);
@@ -276,7 +294,12 @@ void *net_udp_host_thread(void *arg) {
         }
 
         while (net_udp_service(host, &ev, 100) > 0) {
-            buf_spsc_ring_push(&host->eventBuffer, &ev);
+            if (buf_spsc_ring_push(&host->eventBuffer, &ev)) {
+                // Wake a consumer blocked in net_udp_host_wait_events
+                mutex_lock(&host->hostLock);
+                condvar_broadcast(&host->eventCond);
+                mutex_unlock(&host->hostLock);
+            }
         }
 
         // shutdown process if requested
@@ -295,6 +318,7 @@ void *net_udp_host_thread(void *arg) {
                 host->shutdownStartTime + NET_HOST_SHUTDOWN_TIMEOUT_NS > time_now_ns()) {
                 host->threadRunning = 0;
                 host->state = NET_HOST_STOPPED;
+                mutex_unlock(&host->hostLock);
                 break;
             }
         }
@@ -0,0 +1,164 @@
+#include <stdlib.h>
+
+#include "common/logger.h"
+#include "common/buffer/arena.h"
+#include "common/thread/condvar.h"
+#include "common/thread/mutex.h"
+#include "common/thread/thread.h"
+#include "common/thread/worker_pool.h"
+
+typedef struct worker_arg_s {
+    worker_pool_t *pool;
+    uint32_t index;
+} worker_arg_t;
+
+struct worker_pool_s {
+    thread_t *threads;
+    worker_arg_t *args;
+    uint32_t numThreads;
+
+    mutex_t lock;
+    cond_t workCond;
+    cond_t doneCond;
+
+    worker_job_t job;
+    void *userData;
+    uint64_t generation;
+    uint32_t pending;
+    uint8_t shutdown;
+};
+
+void *worker_pool_thread(void *userData);
+
+worker_pool_t *worker_pool_create(const uint32_t numThreads) {
+    uint32_t i;
+    worker_pool_t *pool = calloc(1, sizeof(worker_pool_t));
+    if (!pool) {
+        log_error("Failed to allocate memory for worker pool");
+        return NULL;
+    }
+
+    if (numThreads > 0) {
+        pool->threads = calloc(numThreads, sizeof(thread_t));
+        pool->args = calloc(numThreads, sizeof(worker_arg_t));
+        if (!pool->threads || !pool->args) {
+            log_error("Failed to allocate memory for worker threads");
+            free(pool->threads);
+            free(pool->args);
+            free(pool);
+            return NULL;
+        }
+    }
+
+    mutex_init(&pool->lock);
+    condvar_init(&pool->workCond);
+    condvar_init(&pool->doneCond);
+
+    for (i = 0; i < numThreads; i++) {
+        pool->args[i].pool = pool;
+        pool->args[i].index = i + 1; // Index 0 is reserved for the dispatching thread
+        if (thread_create(&pool->threads[i], worker_pool_thread, &pool->args[i]) < 0) {
+            log_error("Failed to create worker thread %u, continuing with %u", i + 1, i);
+            break;
+        }
+        pool->numThreads++;
+    }
+
+    return pool;
+}
+
+void worker_pool_destroy(worker_pool_t *pool) {
+    uint32_t i;
+    if (!pool) {
+        return;
+    }
+
+    mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    condvar_broadcast(&pool->workCond);
+    mutex_unlock(&pool->lock);
+
+    for (i = 0; i < pool->numThreads; i++) {
+        thread_join(&pool->threads[i]);
+    }
+
+    condvar_destroy(&pool->doneCond);
+    condvar_destroy(&pool->workCond);
+    mutex_destroy(&pool->lock);
+
+    free(pool->threads);
+    free(pool->args);
+    free(pool);
+}
+
+uint32_t worker_pool_get_size(const worker_pool_t *pool) {
+    if (!pool) {
+        return 1;
+    }
+
+    return pool->numThreads + 1;
+}
+
+void worker_pool_run(worker_pool_t *pool, const worker_job_t job, void *userData) {
+    if (!job) {
+        return;
+    }
+
+    if (!pool || pool->numThreads == 0) {
+        job(userData, 0, 1);
+        return;
+    }
+
+    mutex_lock(&pool->lock);
+    pool->job = job;
+    pool->userData = userData;
+    pool->pending = pool->numThreads;
+    pool->generation++;
+    condvar_broadcast(&pool->workCond);
+    mutex_unlock(&pool->lock);
+
+    job(userData, 0, pool->numThreads + 1);
+
+    mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        condvar_wait(&pool->doneCond, &pool->lock);
+    }
+    mutex_unlock(&pool->lock);
+}
+
+void *worker_pool_thread(void *userData) {
+    worker_arg_t *arg = (worker_arg_t *) userData;
+    worker_pool_t *pool = arg->pool;
+    uint64_t seenGeneration = 0;
+    worker_job_t job;
+    void *jobData;
+
+    while (1) {
+        mutex_lock(&pool->lock);
+        while (!pool->shutdown && pool->generation == seenGeneration) {
+            condvar_wait(&pool->workCond, &pool->lock);
+        }
+
+        if (pool->shutdown) {
+            mutex_unlock(&pool->lock);
+            break;
+        }
+
+        seenGeneration = pool->generation;
+        job = pool->job;
+        jobData = pool->userData;
+        mutex_unlock(&pool->lock);
+
+        job(jobData, arg->index, pool->numThreads + 1);
+        buf_tick_reset(); // Jobs only allocate scratch data, nothing outlives them on worker threads
+
+        mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            condvar_signal(&pool->doneCond);
+        }
+        mutex_unlock(&pool->lock);
+    }
+
+    buf_tick_close();
+    return NULL;
+}
@@ -0,0 +1,174 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/timer_wheel.h"
+
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_MAX_DELTA ((1ull << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_BITS)) - 1)
+
+static int timer_wheel_grow_array(void **array, const size_t size, const uint32_t count) {
+    void *newArray = realloc(*array, size * count);
+    if (!newArray) return 0;
+
+    *array = newArray;
+    return 1;
+}
+
+// Buckets at level n hold deadlines less than TIMER_WHEEL_SLOTS^(n+1) ticks away, keyed by the deadline's
+// digit at that level, so every bucket is reached again by the time its earliest deadline comes up
+static void timer_wheel_link(timer_wheel_t *wheel, const uint32_t timer) {
+    uint64_t deadline = wheel->deadlines[timer];
+    uint64_t delta = deadline > wheel->now ? deadline - wheel->now : 0;
+    uint32_t level = 0, bucket;
+
+    if (delta > TIMER_WHEEL_MAX_DELTA) {
+        deadline = wheel->now + TIMER_WHEEL_MAX_DELTA; // Parked at the top level, cascades move it down once in range
+        delta = TIMER_WHEEL_MAX_DELTA;
+    }
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= 1ull << ((level + 1) * TIMER_WHEEL_BITS)) {
+        level++;
+    }
+
+    bucket = level * TIMER_WHEEL_SLOTS + (uint32_t) ((deadline >> (level * TIMER_WHEEL_BITS)) & TIMER_WHEEL_MASK);
+    wheel->buckets[timer] = bucket;
+    wheel->prev[timer] = TIMER_WHEEL_NONE;
+    wheel->next[timer] = wheel->heads[bucket];
+    if (wheel->heads[bucket] != TIMER_WHEEL_NONE) {
+        wheel->prev[wheel->heads[bucket]] = timer;
+    }
+    wheel->heads[bucket] = timer;
+}
+
+static void timer_wheel_unlink(timer_wheel_t *wheel, const uint32_t timer) {
+    const uint32_t bucket = wheel->buckets[timer];
+
+    if (wheel->prev[timer] == TIMER_WHEEL_NONE) {
+        wheel->heads[bucket] = wheel->next[timer];
+    } else {
+        wheel->next[wheel->prev[timer]] = wheel->next[timer];
+    }
+    if (wheel->next[timer] != TIMER_WHEEL_NONE) {
+        wheel->prev[wheel->next[timer]] = wheel->prev[timer];
+    }
+    wheel->buckets[timer] = TIMER_WHEEL_NONE;
+}
+
+static void timer_wheel_cascade(timer_wheel_t *wheel, const uint32_t level) {
+    const uint32_t bucket = level * TIMER_WHEEL_SLOTS + (uint32_t) ((wheel->now >> (level * TIMER_WHEEL_BITS)) & TIMER_WHEEL_MASK);
+    uint32_t timer = wheel->heads[bucket], next;
+
+    wheel->heads[bucket] = TIMER_WHEEL_NONE;
+    while (timer != TIMER_WHEEL_NONE) {
+        next = wheel->next[timer];
+        timer_wheel_link(wheel, timer);
+        timer = next;
+    }
+}
+
+int timer_wheel_init(timer_wheel_t* wheel, const uint32_t capacity) {
+    uint32_t i;
+    if (!wheel) {
+        return 0;
+    }
+
+    memset(wheel, 0, sizeof(timer_wheel_t));
+    for (i = 0; i < TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS; i++) {
+        wheel->heads[i] = TIMER_WHEEL_NONE;
+    }
+
+    if (!timer_wheel_reserve(wheel, capacity)) {
+        timer_wheel_destroy(wheel);
+        return 0;
+    }
+    return 1;
+}
+
+void timer_wheel_destroy(timer_wheel_t* wheel) {
+    if (!wheel) {
+        return;
+    }
+
+    free(wheel->deadlines);
+    free(wheel->next);
+    free(wheel->prev);
+    free(wheel->buckets);
+    memset(wheel, 0, sizeof(timer_wheel_t));
+}
+
+int timer_wheel_reserve(timer_wheel_t* wheel, const uint32_t capacity) {
+    uint32_t i;
+    if (!wheel) {
+        return 0;
+    }
+    if (capacity <= wheel->capacity) {
+        return 1;
+    }
+
+    if (!timer_wheel_grow_array((void **) &wheel->deadlines, sizeof(uint64_t), capacity) ||
+        !timer_wheel_grow_array((void **) &wheel->next, sizeof(uint32_t), capacity) ||
+        !timer_wheel_grow_array((void **) &wheel->prev, sizeof(uint32_t), capacity) ||
+        !timer_wheel_grow_array((void **) &wheel->buckets, sizeof(uint32_t), capacity)) {
+        return 0;
+    }
+
+    for (i = wheel->capacity; i < capacity; i++) {
+        wheel->buckets[i] = TIMER_WHEEL_NONE;
+    }
+    wheel->capacity = capacity;
+    return 1;
+}
+
+void timer_wheel_schedule(timer_wheel_t* wheel, const uint32_t timer, uint32_t delay) {
+    if (!wheel || timer >= wheel->capacity) {
+        return;
+    }
+
+    if (wheel->buckets[timer] != TIMER_WHEEL_NONE) {
+        timer_wheel_unlink(wheel, timer);
+    } else {
+        wheel->count++;
+    }
+
+    if (delay == 0) delay = 1;
+    wheel->deadlines[timer] = wheel->now + delay;
+    timer_wheel_link(wheel, timer);
+}
+
+void timer_wheel_cancel(timer_wheel_t* wheel, const uint32_t timer) {
+    if (!timer_wheel_pending(wheel, timer)) {
+        return;
+    }
+
+    timer_wheel_unlink(wheel, timer);
+    wheel->count--;
+}
+
+int timer_wheel_pending(const timer_wheel_t* wheel, const uint32_t timer) {
+    return wheel && timer < wheel->capacity && wheel->buckets[timer] != TIMER_WHEEL_NONE;
+}
+
+uint32_t timer_wheel_advance(timer_wheel_t* wheel, const timer_wheel_fire_fn fn, void* userData) {
+    uint32_t level, bucket, timer, fired = 0;
+    if (!wheel) {
+        return 0;
+    }
+
+    wheel->now++;
+
+    // Higher levels first so timers cascading down can land in a lower bucket that cascades this same tick
+    for (level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+        if ((wheel->now & ((1ull << (level * TIMER_WHEEL_BITS)) - 1)) == 0) {
+            timer_wheel_cascade(wheel, level);
+        }
+    }
+
+    bucket = (uint32_t) (wheel->now & TIMER_WHEEL_MASK);
+    while ((timer = wheel->heads[bucket]) != TIMER_WHEEL_NONE) {
+        timer_wheel_unlink(wheel, timer);
+        wheel->count--;
+        fired++;
+        if (fn) fn(userData, timer);
+    }
+
+    return fired;
+}
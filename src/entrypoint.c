@@ -1,10 +1,14 @@
+#include <stdlib.h>
 #include <string.h>
 
 #include "common/logger.h"
+#include "common/game/game.h"
 #include "client/client.h"
 #include "server/server.h"
+#include "server/bench.h"
 
-uint8_t _dedicatedServer;
+uint8_t _dedicatedServer, _benchSim;
+bench_settings_t _benchSettings;
 
 // development flags
 uint8_t __DEBUG = 0, __DEBUG_LINES = 0, __INF_RESOURCES = 0, __INF_DAMAGE = 0;
@@ -17,8 +21,12 @@ int main(int argc, char * argv[]) {
     logger_init("gf2d.log", LOG_INFO, LOG_DEBUG);
 
     log_info("---==== BEGIN ====---");
+    game_register_entity_types();
 
-    if (_dedicatedServer) {
+    if (_benchSim) {
+        log_info("Starting in BENCHMARK mode");
+        server_bench_main(&_benchSettings);
+    } else if (_dedicatedServer) {
         log_info("Starting in SERVER mode");
         server_main();
     } else {
@@ -48,6 +56,22 @@ void parse_arguments(int argc,char *argv[]) {
         if (strcmp(argv[a],"--inf-damage") == 0) {
             __INF_DAMAGE = 1;
         }
+        if (strcmp(argv[a],"--matches") == 0 && a + 1 < argc) {
+            g_server.matchCount = (uint32_t) strtoul(argv[++a], NULL, 10);
+        }
+        if (strcmp(argv[a],"--max-entities") == 0 && a + 1 < argc) {
+            g_server.maxEntities = (uint32_t) strtoul(argv[++a], NULL, 10);
+            _benchSettings.maxEntities = g_server.maxEntities;
+        }
+        if (strcmp(argv[a],"--bench-sim") == 0) {
+            _benchSim = 1;
+        }
+        if (strcmp(argv[a],"--bench-ticks") == 0 && a + 1 < argc) {
+            _benchSettings.ticks = (uint32_t) strtoul(argv[++a], NULL, 10);
+        }
+        if (strcmp(argv[a],"--bench-workers") == 0 && a + 1 < argc) {
+            _benchSettings.workers = (uint32_t) strtoul(argv[++a], NULL, 10);
+        }
     }
 }
 /*eol@eof*/
\ No newline at end of file
@@ -0,0 +1,237 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/def.h"
+#include "common/logger.h"
+#include "common/time.h"
+#include "common/buffer/arena.h"
+#include "common/game/collision_batch.h"
+#include "common/game/enemy.h"
+#include "common/game/entity.h"
+#include "common/game/game.h"
+#include "common/game/item.h"
+#include "common/game/projectile.h"
+#include "common/game/tower.h"
+#include "common/game/world/tile.h"
+#include "common/game/world/world.h"
+#include "common/thread/worker_pool.h"
+
+#include "server/bench.h"
+#include "server/server.h"
+
+#define BENCH_TOWER_SPACING 3 // Tiles between tower centers
+#define BENCH_TOWER_RADIUS 9 // Tiles from the stash to the outermost towers
+
+typedef enum bench_phase_e {
+    BENCH_PHASE_WORLD = 0,
+    BENCH_PHASE_THINK = 1,
+    BENCH_PHASE_SPLASH = 2,
+    BENCH_PHASE_UPDATE = 3,
+    BENCH_PHASE_DESTROY = 4,
+    BENCH_PHASE_REORDER = 5,
+    BENCH_PHASE_COUNT
+} bench_phase_t;
+
+static const char *bench_phase_names[BENCH_PHASE_COUNT] = {
+    "world_update",
+    "entity_think",
+    "splash_resolve",
+    "entity_update",
+    "entity_destroy",
+    "entity_reorder"
+};
+
+static int bench_setup(uint32_t maxEntities);
+static uint32_t bench_place_towers(GFC_Vector2D center);
+static void bench_print_state_pool(const char *name, entity_type_t type);
+
+int server_bench_main(const bench_settings_t *settings) {
+    worker_pool_t *workers = NULL;
+    uint64_t phaseNs[BENCH_PHASE_COUNT] = {0};
+    uint64_t start, phaseStart, totalNs, tickNs, worstTickNs = 0;
+    uint32_t ticks, i, numTowers;
+    entity_pool_stats_t poolStats;
+    const float deltaTime = (float) SERVER_TARGET_SECONDS_PER_TICK;
+    double seconds;
+    GFC_Vector2D center;
+
+    ticks = settings && settings->ticks ? settings->ticks : BENCH_DEFAULT_TICKS;
+    srand(BENCH_SEED);
+
+    if (!bench_setup(settings ? settings->maxEntities : 0)) {
+        log_error("Failed to set up simulation benchmark");
+        return -1;
+    }
+
+    if (settings && settings->workers > 0) {
+        workers = worker_pool_create(settings->workers);
+    }
+
+    center = gfc_vector2d(
+        g_game.world->size.x * CHUNK_TILE_SIZE * TILE_SIZE / 2.0f,
+        g_game.world->size.y * CHUNK_TILE_SIZE * TILE_SIZE / 2.0f);
+    numTowers = bench_place_towers(center);
+
+    // Skip exploring, the stash is down and the first wave starts after one building phase
+    g_game.state.phase = GAME_PHASE_BUILDING;
+    g_game.state.stashPosition = center;
+
+    log_info("Benchmarking %u ticks with %u towers and %u worker(s)...", ticks, numTowers, worker_pool_get_size(workers));
+    start = time_now_ns();
+    for (i = 0; i < ticks; i++) {
+        tickNs = time_now_ns();
+        g_game.tickNumber++;
+        g_game.deltaTime = deltaTime;
+
+        phaseStart = time_now_ns();
+        world_update(g_game.world, deltaTime);
+        phaseNs[BENCH_PHASE_WORLD] += time_now_ns() - phaseStart;
+
+        phaseStart = time_now_ns();
+        entity_think_all_parallel(g_game.entityManager, workers);
+        phaseNs[BENCH_PHASE_THINK] += time_now_ns() - phaseStart;
+
+        phaseStart = time_now_ns();
+        projectile_resolve_splashes(g_game.entityManager);
+        phaseNs[BENCH_PHASE_SPLASH] += time_now_ns() - phaseStart;
+
+        phaseStart = time_now_ns();
+        entity_update_all(g_game.entityManager, deltaTime);
+        phaseNs[BENCH_PHASE_UPDATE] += time_now_ns() - phaseStart;
+
+        phaseStart = time_now_ns();
+        entity_flush_destroyed(g_game.entityManager);
+        phaseNs[BENCH_PHASE_DESTROY] += time_now_ns() - phaseStart;
+
+        phaseStart = time_now_ns();
+        entity_reorder_spatial(g_game.entityManager);
+        phaseNs[BENCH_PHASE_REORDER] += time_now_ns() - phaseStart;
+
+        buf_tick_reset(); // Nobody is connected, queued packets are simply dropped
+
+        tickNs = time_now_ns() - tickNs;
+        if (tickNs > worstTickNs) {
+            worstTickNs = tickNs;
+        }
+    }
+    totalNs = time_now_ns() - start;
+    seconds = (double) totalNs / 1e9;
+    entity_get_pool_stats(g_game.entityManager, &poolStats);
+
+    printf("---- simulation benchmark ----\n");
+    printf("ticks:          %u (%.1f s game time)\n", ticks, ticks * deltaTime);
+    printf("waves reached:  %lu\n", (unsigned long) g_game.state.waveNumber);
+    printf("peak entities:  %u\n", poolStats.highWater);
+    printf("entity pool:    %u/%u slots in %u chunk(s), %u failed spawns\n",
+        poolStats.capacity, poolStats.limit, poolStats.numChunks, poolStats.allocFailures);
+    printf("asleep at end:  %u of %u entities\n", poolStats.numAsleep, poolStats.numEnts);
+    bench_print_state_pool("enemy states:", ENTITY_TYPE_ENEMY);
+    bench_print_state_pool("proj. states:", ENTITY_TYPE_PROJECTILE);
+    printf("tick arena:     %.1f KiB peak\n", buf_tick_arena()->peak / 1024.0);
+    printf("collision simd: %s\n", collision_batch_kernel_name());
+    printf("wall time:      %.3f s\n", seconds);
+    printf("ticks/sec:      %.1f (%.1fx real time)\n", ticks / seconds, ticks / seconds / SERVER_TARGET_TICKRATE);
+    printf("worst tick:     %.3f ms\n", worstTickNs / 1e6);
+    for (i = 0; i < BENCH_PHASE_COUNT; i++) {
+        printf("%-15s %.4f ms/tick (%.1f%%)\n", bench_phase_names[i],
+            phaseNs[i] / 1e6 / ticks, totalNs ? 100.0 * phaseNs[i] / totalNs : 0.0);
+    }
+
+    worker_pool_destroy(workers);
+    return 0;
+}
+
+static int bench_setup(const uint32_t maxEntities) {
+    size_t i;
+
+    g_game.role = GAME_ROLE_SERVER;
+    g_game.tickNumber = 0;
+    g_game.deltaTime = 0.0f;
+
+    g_game.defManager = def_init(32);
+    g_game.entityManager = entity_init(ENTITY_DEFAULT_CAPACITY, maxEntities);
+    g_game.itemDefManager = item_init(g_game.defManager, "def/items.json");
+    g_game.towerManager = tower_init(tower_load_defs(g_game.defManager, "def/towers.json"), 128);
+    g_game.enemyManager = enemy_load_defs(g_game.defManager, "def/enemies.json");
+    g_game.tileManager = tile_manager_init("def/tiles.json");
+    if (!g_game.entityManager || !g_game.towerManager) {
+        return 0;
+    }
+
+    strncpy(g_game.state.world, "worlds/test.bin", sizeof(g_game.state.world) - 1);
+    g_game.state.mode = GAME_MODE_SINGLEPLAYER;
+    g_game.state.winnerTeamID = TEAM_NONE;
+    for (i = 0; i < TEAM_COUNT; i++) {
+        g_game.state.teamStashPositions[i] = gfc_vector2d(0, 0);
+        g_game.state.teamStashTowerIDs[i] = UINT32_MAX;
+        g_game.state.teamStashAlive[i] = 0;
+    }
+    g_game.world = world_create_from_file(g_game.state.world);
+    if (!g_game.world) {
+        return 0;
+    }
+
+    g_game.state.phase = GAME_PHASE_EXPLORING;
+    g_game.state.waveNumber = 1;
+    g_game.state.cycleTime = HALF_CYCLE_TIME;
+    g_game.state.stashPosition = gfc_vector2d(0, 0);
+    return 1;
+}
+
+static uint32_t bench_place_towers(const GFC_Vector2D center) {
+    const tower_def_t *def, *stashDef = NULL;
+    const tower_def_t *defensiveDefs[32];
+    uint32_t numDefensive = 0, numTowers = 0;
+    entity_t *ent;
+    int i, x, y;
+
+    for (i = 0; (def = tower_def_get_by_index(g_game.towerManager, i)) != NULL; i++) {
+        if (def->type == TOWER_TYPE_STASH && !stashDef) {
+            stashDef = def;
+        } else if (def->type == TOWER_TYPE_DEFENSIVE && numDefensive < 32) {
+            defensiveDefs[numDefensive++] = def;
+        }
+    }
+
+    if (stashDef) {
+        ent = tower_create_by_def(g_game.entityManager, g_game.towerManager, stashDef, center);
+        if (ent && ent->data) {
+            ((tower_state_t *) ent->data)->teamID = TEAM_ONE;
+            numTowers++;
+        }
+    }
+
+    if (numDefensive == 0) {
+        log_warn("No defensive towers defined, benchmarking without defenses");
+        return numTowers;
+    }
+
+    // Fill a square around the stash, cycling through every defensive tower
+    for (y = -BENCH_TOWER_RADIUS; y <= BENCH_TOWER_RADIUS; y += BENCH_TOWER_SPACING) {
+        for (x = -BENCH_TOWER_RADIUS; x <= BENCH_TOWER_RADIUS; x += BENCH_TOWER_SPACING) {
+            if (x == 0 && y == 0) {
+                continue;
+            }
+
+            def = defensiveDefs[numTowers % numDefensive];
+            ent = tower_create_by_def(g_game.entityManager, g_game.towerManager, def,
+                gfc_vector2d(center.x + x * TILE_SIZE, center.y + y * TILE_SIZE));
+            if (ent && ent->data) {
+                ((tower_state_t *) ent->data)->teamID = TEAM_ONE;
+                numTowers++;
+            }
+        }
+    }
+
+    return numTowers;
+}
+
+static void bench_print_state_pool(const char *name, const entity_type_t type) {
+    const buf_pool_t *pool = entity_get_state_pool(g_game.entityManager, type);
+    if (!pool) {
+        return;
+    }
+
+    printf("%-15s peak %u/%u, %u in use, %u heap fallbacks\n", name, pool->peak, pool->capacity, pool->count, pool->overflows);
+}
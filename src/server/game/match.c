@@ -0,0 +1,423 @@
+#include <math.h>
+#include <string.h>
+
+#include "common/def.h"
+#include "common/logger.h"
+#include "common/time.h"
+#include "common/buffer/arena.h"
+#include "common/game/enemy.h"
+#include "common/game/entity.h"
+#include "common/game/item.h"
+#include "common/game/projectile.h"
+#include "common/game/tower.h"
+#include "common/game/world/tile.h"
+#include "common/game/world/world.h"
+#include "common/network/network.h"
+
+#include "server/server.h"
+#include "server/game/match.h"
+#include "server/game/player_manager.h"
+#include "server/network/network_session.h"
+#include "server/network/server_network.h"
+
+__thread match_t *g_match = NULL;
+
+void *match_run(void *arg);
+int match_startup(match_t *match);
+void match_tick(match_t *match, float deltaTime);
+void match_tickProcessor(match_t *match);
+
+static int match_hibernate(match_t *match);
+static void match_process_events(match_t *match);
+static void match_sync_sessions(match_t *match);
+
+match_manager_t *match_manager_create(const uint32_t numMatches, const game_mode_t mode, struct worker_pool_s *workers) {
+    match_manager_t *manager;
+    match_t *match;
+    uint32_t i, running = 0;
+    if (numMatches == 0) {
+        log_error("Cannot create a match manager without matches");
+        return NULL;
+    }
+
+    manager = gfc_allocate_array(sizeof(match_manager_t), 1);
+    if (!manager) {
+        log_error("Failed to allocate memory for match manager");
+        return NULL;
+    }
+
+    manager->matches = gfc_allocate_array(sizeof(match_t), numMatches);
+    if (!manager->matches) {
+        log_error("Failed to allocate memory for matches");
+        free(manager);
+        return NULL;
+    }
+
+    // Definitions are immutable once loaded, every match shares them
+    g_game.defManager = def_init(32);
+    g_game.itemDefManager = item_init(g_game.defManager, "def/items.json");
+    manager->towerDefs = tower_load_defs(g_game.defManager, "def/towers.json");
+    g_game.enemyManager = enemy_load_defs(g_game.defManager, "def/enemies.json");
+    g_game.tileManager = tile_manager_init("def/tiles.json");
+
+    manager->defManager = g_game.defManager;
+    manager->itemDefManager = g_game.itemDefManager;
+    manager->enemyManager = g_game.enemyManager;
+    manager->tileManager = g_game.tileManager;
+
+    for (i = 0; i < numMatches; i++) {
+        match = &manager->matches[i];
+        match->id = i;
+        match->state = MATCH_IDLE;
+        match->nextJoinTeamID = TEAM_ONE;
+        match->towerDefs = manager->towerDefs;
+        match->workers = numMatches == 1 ? workers : NULL; // Matches already run side by side, only a lone match fans out
+        mutex_init(&match->lock);
+        condvar_init(&match->wakeCond);
+
+        match->game.defManager = manager->defManager;
+        match->game.itemDefManager = manager->itemDefManager;
+        match->game.tileManager = manager->tileManager;
+        match->game.enemyManager = manager->enemyManager;
+        match->game.state.mode = mode;
+
+        match->playerManager = player_manager_create(MATCH_MAX_PLAYERS);
+        if (!match->playerManager || !buf_spsc_ring_init(&match->events, MATCH_EVENT_QUEUE_SIZE, sizeof(net_udp_event_t))) {
+            log_error("Failed to allocate match %u", match->id);
+            match->state = MATCH_STOPPED;
+            continue;
+        }
+
+        if (thread_create(&match->thread, match_run, match) < 0) {
+            log_error("Failed to create thread for match %u", match->id);
+            match->state = MATCH_STOPPED;
+            continue;
+        }
+        match->hasThread = 1;
+    }
+    manager->numMatches = numMatches;
+
+    // Wait for every match to load its world before accepting sessions
+    for (i = 0; i < numMatches; i++) {
+        match = &manager->matches[i];
+        while (1) {
+            mutex_lock(&match->lock);
+            if (match->state != MATCH_IDLE) {
+                running += match->state == MATCH_RUNNING;
+                mutex_unlock(&match->lock);
+                break;
+            }
+            mutex_unlock(&match->lock);
+            thread_sleepMs(1);
+        }
+    }
+
+    if (running == 0) {
+        log_error("No match could be started");
+        match_manager_destroy(manager);
+        return NULL;
+    }
+
+    log_info("Started %u of %u matches", running, numMatches);
+    return manager;
+}
+
+void match_manager_destroy(match_manager_t *manager) {
+    match_t *match;
+    uint32_t i;
+    if (!manager) {
+        return;
+    }
+
+    for (i = 0; i < manager->numMatches; i++) {
+        match = &manager->matches[i];
+        mutex_lock(&match->lock);
+        if (match->state == MATCH_IDLE || match->state == MATCH_RUNNING) {
+            match->state = MATCH_SHUTDOWN_REQUESTED;
+        }
+        condvar_broadcast(&match->wakeCond);
+        mutex_unlock(&match->lock);
+    }
+
+    for (i = 0; i < manager->numMatches; i++) {
+        match = &manager->matches[i];
+        if (match->hasThread) {
+            thread_join(&match->thread);
+        }
+
+        buf_spsc_ring_destroy(&match->events);
+        player_manager_destroy(match->playerManager);
+        condvar_destroy(&match->wakeCond);
+        mutex_destroy(&match->lock);
+    }
+
+    free(manager->matches);
+    free(manager);
+}
+
+match_t *match_manager_route(match_manager_t *manager, network_session_t *session) {
+    match_t *match;
+    uint32_t i;
+    if (!manager || !session) {
+        return NULL;
+    }
+
+    // Fill matches in order so players that join together end up together
+    for (i = 0; i < manager->numMatches; i++) {
+        match = &manager->matches[i];
+        mutex_lock(&match->lock);
+        if (match->state == MATCH_RUNNING && match->numSessions < MATCH_MAX_PLAYERS) {
+            match->numSessions++;
+            if (match->hibernating) {
+                condvar_signal(&match->wakeCond);
+            }
+            mutex_unlock(&match->lock);
+
+            session->match = match;
+            log_info("Routed session ID %u to match %u", session->sessionID, match->id);
+            return match;
+        }
+        mutex_unlock(&match->lock);
+    }
+
+    return NULL;
+}
+
+void match_manager_log_status(match_manager_t *manager) {
+    match_t *match;
+    double tps, use;
+    uint32_t i, j;
+    if (!manager) {
+        return;
+    }
+
+    for (i = 0; i < manager->numMatches; i++) {
+        match = &manager->matches[i];
+        tps = 0.0;
+        use = 0.0;
+
+        mutex_lock(&match->lock);
+        for (j = 0; j < 20; j++) {
+            tps += match->averageTps[j];
+            use += match->averageUse[j];
+        }
+        log_info("Match %u: state %d%s, sessions %u/%d, TPS %.2f, CPU use %.2f%%, entities %u (%u asleep, peak %u, %u/%u slots, %u failed spawns)",
+            match->id, match->state, match->hibernating ? " (hibernating)" : "", match->numSessions, MATCH_MAX_PLAYERS,
+            tps / 20.0, use / 20.0 * 100.0, match->entityStats.numEnts, match->entityStats.numAsleep, match->entityStats.highWater,
+            match->entityStats.capacity, match->entityStats.limit, match->entityStats.allocFailures);
+        mutex_unlock(&match->lock);
+    }
+}
+
+int match_push_event(match_t *match, const net_udp_event_t *event) {
+    if (!match || !event) {
+        return 0;
+    }
+
+    if (!buf_spsc_ring_push(&match->events, event)) {
+        return 0;
+    }
+
+    mutex_lock(&match->lock);
+    if (match->hibernating) {
+        condvar_signal(&match->wakeCond);
+    }
+    mutex_unlock(&match->lock);
+    return 1;
+}
+
+void match_release_session(match_t *match) {
+    if (!match) {
+        return;
+    }
+
+    mutex_lock(&match->lock);
+    if (match->numSessions > 0) {
+        match->numSessions--;
+    }
+    mutex_unlock(&match->lock);
+}
+
+void *match_run(void *arg) {
+    match_t *match = (match_t *) arg;
+
+    g_match = match;
+    g_game = match->game;
+
+    if (!match_startup(match)) {
+        log_error("Match %u failed to start", match->id);
+        mutex_lock(&match->lock);
+        match->state = MATCH_STOPPED;
+        mutex_unlock(&match->lock);
+        return NULL;
+    }
+
+    mutex_lock(&match->lock);
+    if (match->state == MATCH_IDLE) {
+        match->state = MATCH_RUNNING;
+    }
+    mutex_unlock(&match->lock);
+
+    match_tickProcessor(match);
+    buf_tick_close();
+    log_info("Match %u stopped", match->id);
+
+    return NULL;
+}
+
+int match_startup(match_t *match) {
+    size_t i;
+
+    g_game.tickNumber = 0;
+    g_game.deltaTime = 0.0f;
+    g_game.role = GAME_ROLE_SERVER;
+
+    g_game.entityManager = entity_init(ENTITY_DEFAULT_CAPACITY, g_server.maxEntities);
+    g_game.towerManager = tower_init(match->towerDefs, 128);
+    if (!g_game.entityManager || !g_game.towerManager) {
+        return 0;
+    }
+
+    strncpy(g_game.state.world, "worlds/test.bin", sizeof(g_game.state.world) - 1);
+    g_game.state.winnerTeamID = TEAM_NONE;
+    for (i = 0; i < TEAM_COUNT; i++) {
+        g_game.state.teamStashPositions[i] = gfc_vector2d(0, 0);
+        g_game.state.teamStashTowerIDs[i] = UINT32_MAX;
+        g_game.state.teamStashAlive[i] = 0;
+    }
+    g_game.world = world_create_from_file(g_game.state.world);
+    if (!g_game.world) {
+        return 0;
+    }
+
+    g_game.state.phase = GAME_PHASE_EXPLORING;
+    g_game.state.waveNumber = 1;
+    g_game.state.cycleTime = HALF_CYCLE_TIME;
+    g_game.state.stashPosition = gfc_vector2d(0, 0);
+
+    return 1;
+}
+
+void match_tick(match_t *match, const float deltaTime) {
+    size_t index;
+    g_game.tickNumber++;
+
+    match_process_events(match);
+    world_update(g_game.world, deltaTime);
+    entity_think_all_parallel(g_game.entityManager, match->workers);
+    projectile_resolve_splashes(g_game.entityManager); // Splash impacts queued during think land together
+    entity_update_all(g_game.entityManager, deltaTime);
+    entity_flush_destroyed(g_game.entityManager); // Despawns from this tick go out as one batch
+    entity_reorder_spatial(g_game.entityManager); // Sorts one window of hot rows by chunk, uses the tick arena
+
+    // Queued packets and transactions live in the tick arena, they have to go out before it resets
+    match_sync_sessions(match);
+    buf_tick_reset();
+
+    mutex_lock(&match->lock);
+    match->currentTps = fmin(SERVER_TARGET_TICKRATE, 1000.0 / deltaTime);
+    match->currentUse = fmin(1.0, deltaTime / SERVER_TARGET_TICK_TIME_MS);
+    entity_get_pool_stats(g_game.entityManager, &match->entityStats);
+
+    index = g_game.tickNumber % 20;
+    match->averageTps[index] = match->currentTps;
+    match->averageUse[index] = match->currentUse;
+    mutex_unlock(&match->lock);
+}
+
+void match_tickProcessor(match_t *match) {
+    const double targetTickMs = SERVER_TARGET_TICK_TIME_MS;
+    double currentTimeMs, frameTimeMs, workTimeMs, deltaSeconds, sleepTimeMs;
+    double previousTimeMs = (double) time_now_ms();
+
+    while (1) {
+        mutex_lock(&match->lock);
+        if (match->state == MATCH_SHUTDOWN_REQUESTED) {
+            match->state = MATCH_STOPPED;
+            mutex_unlock(&match->lock);
+            break;
+        }
+        mutex_unlock(&match->lock);
+
+        // Nothing changes without players, the clock restarts on wake so timers do not jump
+        if (match_hibernate(match)) {
+            previousTimeMs = (double) time_now_ms();
+            continue;
+        }
+
+        currentTimeMs = (double) time_now_ms();
+        frameTimeMs = currentTimeMs - previousTimeMs;
+        previousTimeMs = currentTimeMs;
+
+        deltaSeconds = frameTimeMs / 1000.0;
+
+        g_game.deltaTime = (float) deltaSeconds;
+        match_tick(match, g_game.deltaTime);
+
+        workTimeMs = (double) time_now_ms() - currentTimeMs;
+        sleepTimeMs = targetTickMs - workTimeMs;
+
+        if (sleepTimeMs > 0.0) {
+            thread_sleepMs((uint32_t)sleepTimeMs);
+        } else {
+            log_warn("Match %u overloaded! Behind by %.2f ms", match->id, -sleepTimeMs);
+        }
+    }
+}
+
+static int match_hibernate(match_t *match) {
+    mutex_lock(&match->lock);
+    if (match->numSessions > 0 || match->state != MATCH_RUNNING || !buf_spsc_ring_is_empty(&match->events)) {
+        mutex_unlock(&match->lock);
+        return 0;
+    }
+
+    match->hibernating = 1;
+    log_info("Match %u has no sessions, hibernating", match->id);
+    while (match->numSessions == 0 && match->state == MATCH_RUNNING && buf_spsc_ring_is_empty(&match->events)) {
+        condvar_wait(&match->wakeCond, &match->lock);
+    }
+    match->hibernating = 0;
+    log_info("Match %u resuming", match->id);
+    mutex_unlock(&match->lock);
+    return 1;
+}
+
+static void match_process_events(match_t *match) {
+    net_udp_event_t event;
+    network_session_t *session;
+
+    while (buf_spsc_ring_pop(&match->events, &event)) {
+        switch (event.type) {
+            case NET_UDP_EVENT_TYPE_RECEIVE:
+                // Packet handlers are given the session, the server thread stores its slot in the event data
+                session = server_network_get_session(g_server.network, event.data);
+                if (!session || !session->inUse || session->match != match) {
+                    net_udp_packet_destroy(event.packet);
+                    break;
+                }
+                network_dispatch_packet(&g_server.network->baseNetwork, event.packet, session);
+                break;
+            case NET_UDP_EVENT_TYPE_DISCONNECT:
+                // The server thread stores the session slot in the event data
+                session = server_network_get_session(g_server.network, event.data);
+                server_network_session_close(g_server.network, session);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static void match_sync_sessions(match_t *match) {
+    size_t i, playerCount;
+    const player_t **players;
+
+    players = player_manager_get_all(match->playerManager, &playerCount);
+    for (i = 0; i < playerCount; ++i) {
+        if (!players[i] || !players[i]->data) {
+            continue;
+        }
+        network_session_sync((network_session_t *) players[i]->data);
+    }
+}
@@ -1,14 +1,20 @@
+#include <stdint.h>
+#include <string.h>
+
 #include "common/logger.h"
 
 #include "server/game/player_manager.h"
 
 struct player_manager_s {
     player_t **players;
-    size_t *idToIndexMap;
+    size_t *idToIndexMap; // Indexed by player ID, SIZE_MAX when the ID is unused
+    size_t mapCapacity;
     size_t playerCount;
     size_t capacity;
 };
 
+static int player_manager_reserve_id(player_manager_t *manager, uint32_t id);
+
 player_manager_t *player_manager_create(const size_t initialCapacity) {
     player_manager_t *manager = malloc(sizeof(player_manager_t));
     if (!manager) {
@@ -17,15 +23,16 @@ player_manager_t *player_manager_create(const size_t initialCapacity) {
     }
 
     manager->players = gfc_allocate_array(sizeof(player_t *), initialCapacity);
-    manager->idToIndexMap = gfc_allocate_array(sizeof(uint32_t), initialCapacity);
+    manager->idToIndexMap = gfc_allocate_array(sizeof(size_t), initialCapacity);
     if (!manager->players || !manager->idToIndexMap) {
         if (manager->players) free(manager->players);
         if (manager->idToIndexMap) free(manager->idToIndexMap);
-        manager->capacity = 0;
-        manager->playerCount = 0;
+        free(manager);
         return NULL; // Allocation failed
     }
 
+    memset(manager->idToIndexMap, 0xFF, sizeof(size_t) * initialCapacity);
+    manager->mapCapacity = initialCapacity;
     manager->capacity = initialCapacity;
     manager->playerCount = 0;
     return manager;
@@ -41,43 +48,64 @@ void player_manager_destroy(player_manager_t *manager) {
         player_destroy(manager->players[i]);
     }
     free(manager->players);
-    manager->players = NULL;
-    manager->capacity = 0;
-    manager->playerCount = 0;
+    free(manager->idToIndexMap);
+    free(manager);
 }
 
 int player_manager_resize(player_manager_t *manager, const size_t newCapacity) {
     player_t **newPlayers;
-    size_t *newIdToIndexMap;
     if (newCapacity <= manager->capacity) {
         return 0; // No need to resize
     }
 
     newPlayers = gfc_allocate_array(sizeof(player_t *), newCapacity);
-    newIdToIndexMap = gfc_allocate_array(sizeof(uint32_t), newCapacity);
-    if (!newPlayers || !newIdToIndexMap) {
-        if (newPlayers) free(newPlayers);
-        if (newIdToIndexMap) free(newIdToIndexMap);
+    if (!newPlayers) {
         return -1; // Allocation failed
     }
 
     memcpy(newPlayers, manager->players, sizeof(player_t *) * manager->playerCount);
-    memcpy(newIdToIndexMap, manager->idToIndexMap, sizeof(uint32_t) * manager->playerCount);
-
     free(manager->players);
-    free(manager->idToIndexMap);
 
     manager->players = newPlayers;
-    manager->idToIndexMap = newIdToIndexMap;
     manager->capacity = newCapacity;
 
     return 0; // Success
 }
 
+static int player_manager_reserve_id(player_manager_t *manager, const uint32_t id) {
+    size_t *newIdToIndexMap;
+    size_t newCapacity;
+    if (id < manager->mapCapacity) {
+        return 0;
+    }
+
+    newCapacity = manager->mapCapacity ? manager->mapCapacity * 2 : 8;
+    while (newCapacity <= id) {
+        newCapacity *= 2;
+    }
+
+    newIdToIndexMap = gfc_allocate_array(sizeof(size_t), newCapacity);
+    if (!newIdToIndexMap) {
+        return -1; // Allocation failed
+    }
+
+    memcpy(newIdToIndexMap, manager->idToIndexMap, sizeof(size_t) * manager->mapCapacity);
+    memset(newIdToIndexMap + manager->mapCapacity, 0xFF, sizeof(size_t) * (newCapacity - manager->mapCapacity));
+    free(manager->idToIndexMap);
+
+    manager->idToIndexMap = newIdToIndexMap;
+    manager->mapCapacity = newCapacity;
+    return 0;
+}
+
 player_t *player_manager_add(player_manager_t *manager, const uint32_t id, const char *name) {
     player_t *newPlayer;
-    if (!manager || id >= manager->capacity) {
-        return NULL; // Invalid parameters
+    if (!manager || player_manager_get(manager, id)) {
+        return NULL; // Invalid parameters or duplicate ID
+    }
+
+    if (player_manager_reserve_id(manager, id) < 0) {
+        return NULL; // Resize failed
     }
 
     if (manager->playerCount >= manager->capacity) {
@@ -91,14 +119,14 @@ player_t *player_manager_add(player_manager_t *manager, const uint32_t id, const
         return NULL; // Player creation failed
     }
 
-    manager->players[manager->playerCount] = newPlayer;
-    manager->idToIndexMap[manager->playerCount++] = id;
+    manager->idToIndexMap[id] = manager->playerCount;
+    manager->players[manager->playerCount++] = newPlayer;
     return newPlayer; // Success
 }
 
 void player_manager_remove(player_manager_t *manager, const uint32_t id) {
     size_t idx, toMoveIdx;
-    if (!manager) {
+    if (!manager || id >= manager->mapCapacity) {
         return;
     }
 
@@ -110,15 +138,17 @@ void player_manager_remove(player_manager_t *manager, const uint32_t id) {
     player_destroy(manager->players[idx]);
     toMoveIdx = manager->playerCount - 1;
     manager->players[idx] = manager->players[toMoveIdx];
-    manager->idToIndexMap[idx] = manager->idToIndexMap[toMoveIdx];
+    if (idx != toMoveIdx) {
+        manager->idToIndexMap[manager->players[idx]->id] = idx;
+    }
     manager->players[toMoveIdx] = NULL;
-    manager->idToIndexMap[toMoveIdx] = UINT32_MAX;
+    manager->idToIndexMap[id] = SIZE_MAX;
     manager->playerCount--;
 }
 
 player_t *player_manager_get(player_manager_t *manager, uint32_t id) {
     size_t idx;
-    if (!manager || id >= manager->capacity) {
+    if (!manager || id >= manager->mapCapacity) {
         return NULL; // Invalid parameters
     }
 
@@ -137,4 +167,4 @@ const player_t **player_manager_get_all(player_manager_t *manager, size_t *outCo
 
     *outCount = manager->playerCount;
     return (const player_t **)manager->players;
-}
\ No newline at end of file
+}
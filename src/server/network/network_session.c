@@ -6,6 +6,7 @@
 #include "common/network/packet/definitions.h"
 #include "common/network/packet/io.h"
 #include "server/server.h"
+#include "server/network/server_network.h"
 
 void send_inv_transaction(network_session_t *session, inventory_transaction_t *transaction);
 
@@ -13,6 +14,7 @@ void network_session_create(network_session_t *session, net_udp_peer_t *peer, co
     session->peer = peer;
     session->sessionID = sessionID;
     session->player = NULL;
+    session->match = NULL;
     session->dirtyFlags = 0;
     session->packetQueueSize = 0;
 
@@ -21,13 +23,36 @@ void network_session_create(network_session_t *session, net_udp_peer_t *peer, co
     peer->data = session;
 }
 
+// Queued packets and transactions live in the tick arena, nothing may stay queued past the tick that queued it
+static void network_session_drop_pending(network_session_t *session) {
+    uint32_t i;
+
+    for (i = 0; i < MAX_INV_TRANSACTIONS; i++) {
+        if (session->pendingTransactions[i]) {
+            inventory_transaction_destroy(session->pendingTransactions[i]);
+            session->pendingTransactions[i] = NULL;
+        }
+    }
+    session->dirtyFlags &= ~SESSION_DIRTY_INVENTORY;
+    session->packetQueueSize = 0;
+}
+
 void network_session_destroy(network_session_t *session) {
+    if (!session) {
+        return;
+    }
+
     if (session->player) {
         server_destroy_player(session->player);
         session->player = NULL;
     }
 
-    session->peer->data = NULL;
+    network_session_drop_pending(session);
+
+    // The peer may already belong to a new connection, the server thread clears its data on disconnect
+    session->peer = NULL;
+    session->match = NULL;
+    session->dirtyFlags = 0;
 }
 
 void network_session_send(network_session_t *session, void *context, const uint32_t flags) {
@@ -36,7 +61,9 @@ void network_session_send(network_session_t *session, void *context, const uint3
         return;
     }
 
+    mutex_lock(&g_server.network->sendLock);
     network_send(session->peer, context, flags);
+    mutex_unlock(&g_server.network->sendLock);
 }
 
 void network_session_send_batch(network_session_t *session, void *context) {
@@ -54,8 +81,14 @@ void network_session_send_batch(network_session_t *session, void *context) {
 }
 
 void network_session_sync(network_session_t *session) {
-    if (!session || !session->peer) {
-        log_error("Invalid session or peer.");
+    if (!session) {
+        log_error("Invalid session.");
+        return;
+    }
+
+    if (!session->peer) {
+        log_error("Invalid peer for session ID: %u", session->sessionID);
+        network_session_drop_pending(session);
         return;
     }
 
@@ -74,7 +107,9 @@ void network_session_sync(network_session_t *session) {
         return; // No packets to send
     }
 
+    mutex_lock(&g_server.network->sendLock);
     network_send_batch(session->peer, session->packetQueue, session->packetQueueSize);
+    mutex_unlock(&g_server.network->sendLock);
 
     // Clear the packet queue after sending
     session->packetQueueSize = 0;
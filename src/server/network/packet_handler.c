@@ -7,6 +7,7 @@
 #include "common/network/packet/handler.h"
 #include "../../../include/server/network/server_network.h"
 #include "server/server.h"
+#include "server/game/match.h"
 #include "server/game/player_manager.h"
 #include "server/network/network_session.h"
 
@@ -23,20 +24,14 @@ static uint8_t player_can_modify_tower(const player_t *player, const entity_t *t
     return player->teamID != TEAM_NONE && player->teamID == tower->teamID;
 }
 
-void handle_c2s_player_input_snapshot(const c2s_player_input_snapshot_packet_t *packet, void *peer) {
+void handle_c2s_player_input_snapshot(const c2s_player_input_snapshot_packet_t *packet, void *context) {
     player_t *player;
-    network_session_t *session;
-    if (!packet || !peer) {
+    network_session_t *session = (network_session_t *) context;
+    if (!packet || !session) {
         return;
     }
 
-    session = (network_session_t *) ((net_udp_peer_t *) peer)->data;
-    if (!session) {
-        log_warn("Received player input snapshot from peer without valid session");
-        return;
-    }
-
-    player = player_manager_get(g_server.playerManager, session->sessionID);
+    player = player_manager_get(g_match->playerManager, session->sessionID);
     if (!player) {
         log_warn("Received player input snapshot for non-existent player with session ID %u", session->sessionID);
         return;
@@ -45,10 +40,14 @@ void handle_c2s_player_input_snapshot(const c2s_player_input_snapshot_packet_t *
     player_input_process(player, &packet->inputCommand, g_game.deltaTime);
 }
 
-void handle_c2s_player_join_request(const c2s_player_join_request_packet_t *pkt, void *peer) {
+void handle_c2s_player_join_request(const c2s_player_join_request_packet_t *pkt, void *context) {
     size_t playerCount, i;
     const player_t **players;
-    player_t *player = server_create_player(&g_server, ((net_udp_peer_t *) peer)->data);
+    player_t *player = server_create_player(&g_server, (network_session_t *) context);
+    if (!player) {
+        log_warn("Failed to create player for join request");
+        return;
+    }
 
     s2c_player_join_response_packet_t packet;
     create_s2c_player_join_response(
@@ -67,7 +66,7 @@ void handle_c2s_player_join_request(const c2s_player_join_request_packet_t *pkt,
 
     log_info("Created player with ID: %u", player->id);
 
-    players = player_manager_get_all(g_server.playerManager, &playerCount);
+    players = player_manager_get_all(g_match->playerManager, &playerCount);
     for (i = 0; i < playerCount; ++i) {
         player_state_update_data_t updateData;
         s2c_player_state_update_packet_t updatePacket;
@@ -94,21 +93,15 @@ void handle_c2s_player_join_request(const c2s_player_join_request_packet_t *pkt,
     }
 }
 
-void handle_c2s_tower_request(const c2s_tower_request_packet_t *pkt, void *peer) {
+void handle_c2s_tower_request(const c2s_tower_request_packet_t *pkt, void *context) {
     player_t *player;
-    network_session_t *session;
+    network_session_t *session = (network_session_t *) context;
     const tower_def_t *towerDef;
-    if (!pkt || !peer) {
-        return;
-    }
-
-    session = (network_session_t *) ((net_udp_peer_t *) peer)->data;
-    if (!session) {
-        log_warn("Received tower build request from peer without valid session");
+    if (!pkt || !session) {
         return;
     }
 
-    player = player_manager_get(g_server.playerManager, session->sessionID);
+    player = player_manager_get(g_match->playerManager, session->sessionID);
     if (!player) {
         log_warn("Received tower build request for non-existent player with session ID %u", session->sessionID);
         return;
@@ -146,7 +139,7 @@ void handle_c2s_tower_request(const c2s_tower_request_packet_t *pkt, void *peer)
         if (!player_can_modify_tower(player, tower)) {
             return;
         }
-        tower->think = entity_free;
+        entity_queue_destroy(g_game.entityManager, tower);
     } else if (pkt->requestID == TOWER_REQUEST_SET_PRODUCTION_ENEMY) {
         entity_t *tower = tower_get_by_id(g_game.towerManager, pkt->requestData.setProductionData.towerID);
         tower_state_t *towerState;
@@ -165,5 +158,6 @@ void handle_c2s_tower_request(const c2s_tower_request_packet_t *pkt, void *peer)
         }
         towerState->selectedEnemyDefIndex = (int)pkt->requestData.setProductionData.enemyDefIndex;
         towerState->dirtyFlags |= TOWER_DIRTY_SELECTION;
+        entity_wake(g_game.entityManager, tower);
     }
 }
\ No newline at end of file
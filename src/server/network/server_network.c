@@ -3,6 +3,8 @@
 #include "common/logger.h"
 #include "common/network/packet/io.h"
 #include "server/network/server_network.h"
+#include "common/thread/thread.h"
+#include "server/game/match.h"
 #include "server/network/network_session.h"
 #include "server/server.h"
 
@@ -10,6 +12,7 @@ server_network_t g_serverNetwork = {0};
 
 void server_network_client_connect(struct network_s *network, const net_udp_event_t *context);
 void server_network_client_disconnect(struct network_s *network, const net_udp_event_t *context);
+void server_network_client_receive(struct network_s *network, const net_udp_event_t *context);
 
 server_network_t *server_network_create(const network_settings_t *settings) {
     server_network_t *network = malloc(sizeof(server_network_t));
@@ -20,14 +23,16 @@ server_network_t *server_network_create(const network_settings_t *settings) {
     network_init(&network->baseNetwork, settings, network);
     network->baseNetwork.settings.onConnect = server_network_client_connect;
     network->baseNetwork.settings.onDisconnect = server_network_client_disconnect;
+    network->baseNetwork.settings.onReceive = server_network_client_receive;
 
-    network->sessions = malloc(sizeof(network_session_t) * settings->maxSessions);
+    network->sessions = calloc(settings->maxSessions, sizeof(network_session_t));
     if (!network->sessions) {
         goto fail;
     }
     network->maxSessions = settings->maxSessions;
     network->currentSessionCount = 0;
-    network->nextSessionID = 0;
+    mutex_init(&network->sessionLock);
+    mutex_init(&network->sendLock);
 
     return network;
 
@@ -50,6 +55,8 @@ void server_network_destroy(server_network_t *network) {
     }
 
     network_deinit(&network->baseNetwork);
+    mutex_destroy(&network->sendLock);
+    mutex_destroy(&network->sessionLock);
     free(network->sessions);
     free(network);
 }
@@ -95,56 +102,136 @@ void server_network_stop(server_network_t *network) {
 }
 
 void server_network_tick(server_network_t *network) {
-    size_t i;
     if (!network || !network->baseNetwork.running) {
         return;
     }
 
+    // Sessions are synced by the match that owns them
     network_tick(&network->baseNetwork);
-    for (i = 0; i < network->currentSessionCount; ++i) {
-        network_session_sync(&network->sessions[i]);
+}
+
+int server_network_wait(server_network_t *network, const uint32_t timeoutMs) {
+    if (!network) {
+        return 0;
+    }
+
+    return network_wait(&network->baseNetwork, timeoutMs);
+}
+
+size_t server_network_get_session_count(server_network_t *network) {
+    size_t count;
+    if (!network) {
+        return 0;
     }
+
+    mutex_lock(&network->sessionLock);
+    count = network->currentSessionCount;
+    mutex_unlock(&network->sessionLock);
+    return count;
+}
+
+network_session_t *server_network_get_session(server_network_t *network, const uint32_t sessionID) {
+    if (!network || sessionID >= network->maxSessions) {
+        return NULL;
+    }
+
+    return &network->sessions[sessionID];
+}
+
+void server_network_session_close(server_network_t *network, network_session_t *session) {
+    match_t *match;
+    player_state_update_data_t updateData = {0};
+    s2c_player_state_update_packet_t updatePacket;
+    if (!network || !session || !session->inUse) {
+        return;
+    }
+
+    if (session->player && session->player->entity) {
+        create_s2c_player_state_update(&updatePacket, PLAYER_STATE_UPDATE_DELETE, session->player->id, session->player->entity->id, &updateData);
+        server_broadcast_packet(&g_server, &updatePacket, NET_UDP_FLAG_RELIABLE);
+    }
+    log_info("Client disconnected. Session ID: %u", session->sessionID);
+
+    match = session->match;
+    network_session_destroy(session);
+
+    mutex_lock(&network->sessionLock);
+    session->inUse = 0;
+    --network->currentSessionCount;
+    mutex_unlock(&network->sessionLock);
+
+    match_release_session(match);
 }
 
 void server_network_client_connect(struct network_s *network, const net_udp_event_t *context) {
     server_network_t *serverNetwork = network->networkAdapter;
-    if (serverNetwork->currentSessionCount >= serverNetwork->maxSessions) {
+    network_session_t *session = NULL;
+    size_t i;
+
+    mutex_lock(&serverNetwork->sessionLock);
+    for (i = 0; i < serverNetwork->maxSessions; ++i) {
+        if (!serverNetwork->sessions[i].inUse) {
+            session = &serverNetwork->sessions[i];
+            session->inUse = 1;
+            ++serverNetwork->currentSessionCount;
+            break;
+        }
+    }
+    mutex_unlock(&serverNetwork->sessionLock);
+
+    if (!session) {
         log_warn("Max sessions reached. Rejecting new connection.");
         net_udp_peer_disconnect(context->peer, 0);
         return;
     }
 
-    network_session_create(
-        &serverNetwork->sessions[serverNetwork->currentSessionCount++],
-        context->peer,
-        serverNetwork->nextSessionID++
-    );
-    log_info("Client connected. Assigned Session ID: %u", serverNetwork->sessions[serverNetwork->currentSessionCount - 1].sessionID);
+    network_session_create(session, context->peer, (uint32_t) i);
+    log_info("Client connected. Assigned Session ID: %u", session->sessionID);
 }
 
 void server_network_client_disconnect(struct network_s *network, const net_udp_event_t *context) {
     server_network_t *serverNetwork = network->networkAdapter;
-    network_session_t *session;
-    for (size_t i = 0; i < serverNetwork->currentSessionCount; ++i) {
-        if (serverNetwork->sessions[i].peer == context->peer) {
-            session = &serverNetwork->sessions[i];
-            if (session->player) {
-                if (session->player->entity) {
-                    player_state_update_data_t updateData = {0};
-                    s2c_player_state_update_packet_t updatePacket;
-                    create_s2c_player_state_update(&updatePacket, PLAYER_STATE_UPDATE_DELETE, session->player->id, session->player->entity->id, &updateData);
-                    server_broadcast_packet(&g_server, &updatePacket, NET_UDP_FLAG_RELIABLE);
-                }
-                server_destroy_player(session->player);
-            }
-            log_info("Client disconnected. Session ID: %u", session->sessionID);
-
-            // Shift remaining sessions down
-            for (size_t j = i; j < serverNetwork->currentSessionCount - 1; ++j) {
-                serverNetwork->sessions[j] = serverNetwork->sessions[j + 1];
-            }
-            --serverNetwork->currentSessionCount;
-            break;
-        }
+    network_session_t *session = context->peer->data;
+    net_udp_event_t event;
+    if (!session) {
+        return;
+    }
+
+    context->peer->data = NULL;
+    if (!session->match) {
+        server_network_session_close(serverNetwork, session);
+        return;
     }
-}
\ No newline at end of file
+
+    // Let the owning match tear the player down on its own thread
+    event = *context;
+    event.data = session->sessionID;
+    while (!match_push_event(session->match, &event)) {
+        thread_sleepMs(1);
+    }
+}
+
+void server_network_client_receive(struct network_s *network, const net_udp_event_t *context) {
+    network_session_t *session = context->peer->data;
+    net_udp_event_t event;
+    if (!session) {
+        net_udp_packet_destroy(context->packet);
+        return;
+    }
+
+    // Sessions join a match with their first packet, the join request
+    if (!session->match && !match_manager_route(g_server.matchManager, session)) {
+        log_warn("No match has room for session ID %u. Disconnecting.", session->sessionID);
+        net_udp_packet_destroy(context->packet);
+        net_udp_peer_disconnect(context->peer, 0);
+        return;
+    }
+
+    // The match thread resolves the session from its slot, the peer's data may be cleared or reused by then
+    event = *context;
+    event.data = session->sessionID;
+    if (!match_push_event(session->match, &event)) {
+        log_warn("Event queue for match %u is full. Dropping packet from session ID %u.", session->match->id, session->sessionID);
+        net_udp_packet_destroy(context->packet);
+    }
+}
@@ -9,17 +9,20 @@
 
 #include "common/def.h"
 #include "common/time.h"
+#include "common/buffer/arena.h"
 #include "common/game/game.h"
 #include "common/game/item.h"
 #include "common/game/player.h"
 #include "common/game/tower.h"
 #include "../../include/common/game/world/world.h"
 
+#include "server/game/match.h"
 #include "server/game/player_manager.h"
 #include "../../include/server/network/server_network.h"
 #include "client/client.h"
 #include "common/game/enemy.h"
 #include "common/game/world/tile.h"
+#include "common/thread/worker_pool.h"
 #include "server/network/network_session.h"
 Server g_server = {0};
 
@@ -33,10 +36,15 @@ int server_main(void) {
     log_info("Initializing server...");
 
     g_server.state = SERVER_IDLE;
-    g_server.nextJoinTeamID = TEAM_ONE;
     if (g_server.startupMode != GAME_MODE_VERSUS) {
         g_server.startupMode = GAME_MODE_SINGLEPLAYER;
     }
+    if (g_server.matchCount == 0) {
+        g_server.matchCount = 1;
+    } else if (g_server.matchCount > SERVER_MAX_MATCHES) {
+        log_warn("Clamping match count %u to %d", g_server.matchCount, SERVER_MAX_MATCHES);
+        g_server.matchCount = SERVER_MAX_MATCHES;
+    }
     mutex_init(&g_server.lock);
 
     if (thread_create(&g_server.thread, server_run, &g_server) < 0) {
@@ -53,6 +61,7 @@ int server_main(void) {
 }
 
 int server_startup(Server *server) {
+    uint32_t workerCount;
     log_info("Starting server...");
 
     // FIXME: Load configuration from file or arguments
@@ -65,12 +74,6 @@ int server_startup(Server *server) {
         .outBandwidth = 0,
     };
 
-    server->playerManager = player_manager_create(8);
-    if (!server->playerManager) {
-        log_error("Failed to create player manager");
-        return 0;
-    }
-
     // Initialize server subsystems here (networking, database, etc.)
     server->network = server_network_create(&settings);
     if (!server->network) {
@@ -86,22 +89,23 @@ int server_startup(Server *server) {
     }
     log_info("Server network started successfully.");
 
-    g_game.defManager = def_init(32);
-    g_game.entityManager = entity_init(1024*5);
-    g_game.itemDefManager = item_init(g_game.defManager, "def/items.json");
-    g_game.towerManager = tower_init(tower_load_defs(g_game.defManager, "def/towers.json"), 128);
-    g_game.enemyManager = enemy_load_defs(g_game.defManager, "def/enemies.json");
-    g_game.tileManager = tile_manager_init("def/tiles.json");
-
-    strncpy(g_game.state.world, "worlds/test.bin", sizeof(g_game.state.world) - 1);
-    g_game.state.mode = server->startupMode;
-    g_game.state.winnerTeamID = TEAM_NONE;
-    for (size_t i = 0; i < TEAM_COUNT; i++) {
-        g_game.state.teamStashPositions[i] = gfc_vector2d(0, 0);
-        g_game.state.teamStashTowerIDs[i] = UINT32_MAX;
-        g_game.state.teamStashAlive[i] = 0;
+    workerCount = thread_hardware_concurrency() - 1;
+    if (workerCount > SERVER_MAX_SIM_WORKERS) {
+        workerCount = SERVER_MAX_SIM_WORKERS;
+    }
+    server->workers = worker_pool_create(workerCount);
+    if (!server->workers) {
+        log_warn("Failed to create simulation workers, entities will think on the tick thread");
+    }
+
+    log_info("Starting %u match(es)...", server->matchCount);
+    server->matchManager = match_manager_create(server->matchCount, server->startupMode, server->workers);
+    if (!server->matchManager) {
+        log_error("Failed to start matches");
+        worker_pool_destroy(server->workers);
+        server_network_destroy(server->network);
+        return 0;
     }
-    g_game.world = world_create_from_file(g_game.state.world);
 
     log_info("Server started successfully.");
     return 1;
@@ -112,12 +116,19 @@ int server_shutdown(Server *server) {
         return 0;
     }
 
+    log_info("Stopping matches...");
+    match_manager_destroy(server->matchManager);
+    server->matchManager = NULL;
+
     log_info("Stopping server network...");
     server_network_stop(server->network);
     server_network_destroy(server->network);
     server->network = NULL;
     log_info("Server network stopped.");
 
+    worker_pool_destroy(server->workers);
+    server->workers = NULL;
+
     return 1;
 }
 
@@ -152,16 +163,11 @@ void *server_run(void *arg) {
     if (server->onStart) {
         server->onStart(server);
     }
-    // Main server loop
+    // Main server loop, the matches simulate on their own threads
     g_game.tickNumber = 0;
     g_game.deltaTime = 0.0f;
     g_game.role = GAME_ROLE_SERVER;
 
-    g_game.state.phase = GAME_PHASE_EXPLORING;
-    g_game.state.waveNumber = 1;
-    g_game.state.cycleTime = HALF_CYCLE_TIME;
-    g_game.state.stashPosition = gfc_vector2d(0, 0);
-
     server_tickProcessor(server);
     log_info("Server stopped!");
 
@@ -173,10 +179,8 @@ void server_tick(Server *server, float deltaTime) {
     g_game.tickNumber++;
 
     server_network_tick(server->network);
-    world_update(g_game.world, deltaTime);
-    entity_think_all(g_game.entityManager);
-    entity_update_all(g_game.entityManager, deltaTime);
 
+    mutex_lock(&server->lock);
     server->currentTps = fmin(SERVER_TARGET_TICKRATE, 1000.0 / deltaTime);
     server->currentUse = fmin(1.0, deltaTime / SERVER_TARGET_TICK_TIME_MS);
 
@@ -184,10 +188,13 @@ void server_tick(Server *server, float deltaTime) {
     index = g_game.tickNumber % 20;
     server->averageTps[index] = server->currentTps;
     server->averageUse[index] = server->currentUse;
+    mutex_unlock(&server->lock);
+
+    buf_tick_reset();
 }
 
 void server_tickProcessor(Server *server) {
-    uint8_t shutdownRequested = 0;
+    uint8_t shutdownRequested = 0, hibernating = 0;
     const double targetTickMs = SERVER_TARGET_TICK_TIME_MS;
     double currentTimeMs, frameTimeMs, workTimeMs, deltaSeconds, sleepTimeMs;
     double previousTimeMs = (double) time_now_ms();
@@ -211,6 +218,23 @@ void server_tickProcessor(Server *server) {
             break;
         }
 
+        // With nobody connected, block in the network layer until a connection arrives
+        if (server_network_get_session_count(server->network) == 0) {
+            if (!hibernating) {
+                log_info("No sessions connected, hibernating");
+                hibernating = 1;
+            }
+
+            server_network_wait(server->network, SERVER_HIBERNATE_WAIT_MS);
+            server_network_tick(server->network);
+            previousTimeMs = (double) time_now_ms();
+            continue;
+        }
+        if (hibernating) {
+            log_info("Session connected, resuming");
+            hibernating = 0;
+        }
+
         // Perform server tick
         currentTimeMs = (double) time_now_ms();
         frameTimeMs = currentTimeMs - previousTimeMs;
@@ -250,6 +274,7 @@ void server_runCommandLoop(void) {
             log_info("Current TPS: %.2f", g_server.currentTps);
             log_info("Current CPU Use: %.2f%%", g_server.currentUse * 100.0f);
             mutex_unlock(&g_server.lock);
+            match_manager_log_status(g_server.matchManager);
         } else {
             printf("Unknown command: %s", command);
         }
@@ -258,11 +283,11 @@ void server_runCommandLoop(void) {
 
 player_t *server_create_player(Server *server, network_session_t *session) {
     player_t *player;
-    if (!server || !session) {
+    if (!server || !session || !g_match) {
         return NULL;
     }
 
-    player = player_manager_add(server->playerManager, session->sessionID, "");
+    player = player_manager_add(g_match->playerManager, session->sessionID, "");
     if (!player) {
         log_error("Failed to create player for session ID %u", session->sessionID);
         return NULL;
@@ -273,9 +298,9 @@ player_t *server_create_player(Server *server, network_session_t *session) {
     log_info("Created player with ID %u for session ID %u", player->id, session->sessionID);
 
     inventory_init(&player->inventory, 3);
-    player->teamID = g_game.state.mode == GAME_MODE_VERSUS ? server->nextJoinTeamID : TEAM_ONE;
+    player->teamID = g_game.state.mode == GAME_MODE_VERSUS ? g_match->nextJoinTeamID : TEAM_ONE;
     if (g_game.state.mode == GAME_MODE_VERSUS) {
-        server->nextJoinTeamID = (server->nextJoinTeamID == TEAM_ONE) ? TEAM_TWO : TEAM_ONE;
+        g_match->nextJoinTeamID = (g_match->nextJoinTeamID == TEAM_ONE) ? TEAM_TWO : TEAM_ONE;
     }
 
     float half = g_game.world->size.x * CHUNK_TILE_SIZE * TILE_SIZE / 2.0f;
@@ -285,11 +310,11 @@ player_t *server_create_player(Server *server, network_session_t *session) {
 }
 
 void server_destroy_player(struct player_s *player) {
-    if (!player) {
+    if (!player || !g_match) {
         return;
     }
 
-    player_manager_remove(g_server.playerManager, player->id);
+    player_manager_remove(g_match->playerManager, player->id);
     log_info("Destroyed player with ID %u", player->id);
 }
 
@@ -327,11 +352,11 @@ void server_send_packet_batch(Server* server, const player_t *player, void *cont
 void server_broadcast_packet(Server* server, void *context, const uint32_t flags) {
     size_t i, playerCount;
     const player_t **players;
-    if (!server) {
+    if (!server || !g_match) {
         return;
     }
 
-    players = player_manager_get_all(server->playerManager, &playerCount);
+    players = player_manager_get_all(g_match->playerManager, &playerCount);
     for (i = 0; i < playerCount; ++i) {
         log_info("Broadcasting packet to player ID %u", players[i]->id);
         server_send_packet(server, players[i], context, flags);
@@ -340,11 +365,11 @@ void server_broadcast_packet(Server* server, void *context, const uint32_t flags
 void server_broadcast_packet_batch(Server* server, void *context) {
     size_t i, playerCount;
     const player_t **players;
-    if (!server) {
+    if (!server || !g_match) {
         return;
     }
 
-    players = player_manager_get_all(server->playerManager, &playerCount);
+    players = player_manager_get_all(g_match->playerManager, &playerCount);
     for (i = 0; i < playerCount; ++i) {
         server_send_packet_batch(server, players[i], context);
     }